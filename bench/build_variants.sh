@@ -0,0 +1,44 @@
+#!/bin/sh
+#
+# Tempo de uma execução com perdas de cada protocolo em cada variante de
+# compilação (a padrão do makefile, release, lto e pgo), e o ganho sobre a
+# padrão. O treino do pgo usa outra semente. Cada tempo é o menor de 3 execuções.
+#
+set -e
+cd "$(dirname "$0")/.."
+
+make -s gbn abp sr release lto pgo > /dev/null
+
+WORKLOAD="-n 200000 -l 0.1 -c 0.1 -m 20 -v 0 -s 1234"
+
+# best <binário>: menor tempo, em ms, de 3 execuções
+best() {
+    min=0
+
+    for i in 1 2 3; do
+        start=$(date +%s%N)
+        "./$1" $WORKLOAD > /dev/null
+        end=$(date +%s%N)
+        ms=$(( (end - start) / 1000000 ))
+        [ "$ms" -gt 0 ] || ms=1
+
+        if [ "$min" -eq 0 ] || [ "$ms" -lt "$min" ]; then
+            min=$ms
+        fi
+    done
+
+    echo "$min"
+}
+
+echo "Build variants: $WORKLOAD"
+
+for protocol in go-back-n alternating-bit-protocol selective-repeat; do
+    base=$(best "$protocol.out")
+    printf '%-38s %8d ms\n' "$protocol.out" "$base"
+
+    for variant in release lto pgo; do
+        ms=$(best "$protocol-$variant.out")
+        printf '%-38s %8d ms %8s.%02dx\n' "$protocol-$variant.out" "$ms" \
+            $(( base / ms )) $(( base * 100 / ms % 100 ))
+    done
+done
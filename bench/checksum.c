@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "../checksum.h"
+#include "../rng.h"
+#include "bench.h"
+
+/*******************************************************************
+ Cost and strength of each packet checksum: nanoseconds per
+ pkt_checksum() (CRC-32C with and without SSE4.2), and the fraction of
+ corrupted packets whose checksum still matches, for the emulator's
+ corruption model and for common error patterns over the covered bytes.
+**********************************************************************/
+
+#define OPS         20000000L
+#define TRIALS      1000000L
+#define COVERED     (int)CHECKSUM_BYTES
+
+/* error patterns: */
+#define ERR_EMULATOR    0   /* tolayer3(): payload[0] = 'Z', seqnum or acknum = 999999 */
+#define ERR_BIT         1   /* one bit flipped */
+#define ERR_TWO_BITS    2   /* two bits flipped */
+#define ERR_BYTE_SWAP   3   /* two different bytes swapped */
+#define ERR_WORD_SWAP   4   /* two different 16-bit words swapped */
+#define ERR_BURST       5   /* 4 consecutive bytes replaced */
+#define NERRORS         6
+
+static const char *error_names[NERRORS] = {
+    "emulator", "1 bit", "2 bits", "byte swap", "word swap", "4-byte burst",
+};
+
+static struct rng rng;
+
+/* volatile, so the checksums are not optimized away */
+static volatile long long sink = 0;
+
+static long draw(long n) {
+    return (long)(xoshiro_next(&rng) % (uint64_t)n);
+}
+
+/**
+ * Endereço do i-ésimo byte coberto pelo checksum: seqnum, acknum e payload
+ */
+static unsigned char *covered(struct pkt *packet, int i) {
+    if (i < 2 * (int)sizeof(seqnum_t)) {
+        return (unsigned char *)packet + offsetof(struct pkt, seqnum) + i;
+    }
+
+    return (unsigned char *)packet->payload + i - 2 * sizeof(seqnum_t);
+}
+
+/**
+ * Pacote como os dos protocolos: dados (uma letra repetida) ou ACK
+ */
+static void make_packet(int kind, struct pkt *packet) {
+    memset(packet, 0, sizeof(*packet));
+
+    if (draw(2) == 0) {
+        packet->seqnum = 1 + draw(1000000);
+        memset(packet->payload, 'a' + draw(26), 19);
+    } else {
+        packet->acknum = 1 + draw(1000000);
+    }
+
+    packet->checksum = pkt_checksum(kind, packet);
+}
+
+static void corrupt(struct pkt *packet, int error) {
+    int i, j;
+    unsigned char t;
+    float x;
+
+    switch (error) {
+    case ERR_EMULATOR:
+        if ((x = rng_uniform(&rng)) < .75) {
+            packet->payload[0] = 'Z';
+        } else if (x < .875) {
+            packet->seqnum = 999999;
+        } else {
+            packet->acknum = 999999;
+        }
+        break;
+    case ERR_BIT:
+        i = (int)draw(COVERED * 8);
+        *covered(packet, i / 8) ^= 1 << (i % 8);
+        break;
+    case ERR_TWO_BITS:
+        i = (int)draw(COVERED * 8);
+
+        do {
+            j = (int)draw(COVERED * 8);
+        } while (j == i);
+
+        *covered(packet, i / 8) ^= 1 << (i % 8);
+        *covered(packet, j / 8) ^= 1 << (j % 8);
+        break;
+    case ERR_BYTE_SWAP:
+        do {
+            i = (int)draw(COVERED);
+            j = (int)draw(COVERED);
+        } while (*covered(packet, i) == *covered(packet, j));
+
+        t = *covered(packet, i);
+        *covered(packet, i) = *covered(packet, j);
+        *covered(packet, j) = t;
+        break;
+    case ERR_WORD_SWAP:
+        do {
+            i = 2 * (int)draw(COVERED / 2);
+            j = 2 * (int)draw(COVERED / 2);
+        } while (*covered(packet, i) == *covered(packet, j)
+                 && *covered(packet, i + 1) == *covered(packet, j + 1));
+
+        for (int k = 0; k < 2; k++) {
+            t = *covered(packet, i + k);
+            *covered(packet, i + k) = *covered(packet, j + k);
+            *covered(packet, j + k) = t;
+        }
+        break;
+    case ERR_BURST:
+        i = (int)draw(COVERED - 3);
+
+        for (int k = 0; k < 4; k++) {
+            *covered(packet, i + k) = (unsigned char)draw(256);
+        }
+        break;
+    }
+}
+
+/**
+ * Fração dos pacotes com o erro @error que o checksum @kind não detecta
+ * (contando só os que o erro de fato alterou)
+ */
+static double undetected(int kind, int error) {
+    long changed = 0, missed = 0;
+
+    rng_seed(&rng, RNG_XOSHIRO, 9999);
+
+    for (long n = 0; n < TRIALS; n++) {
+        struct pkt packet, original;
+
+        make_packet(kind, &packet);
+        original = packet;
+        corrupt(&packet, error);
+
+        if (memcmp(&packet, &original, sizeof(packet)) == 0) {
+            continue;
+        }
+
+        changed++;
+        missed += pkt_checksum(kind, &packet) == packet.checksum;
+    }
+
+    return changed > 0 ? (double)missed / changed : 0.0;
+}
+
+static double cost(int kind) {
+    struct pkt packet;
+    double start;
+
+    rng_seed(&rng, RNG_XOSHIRO, 9999);
+    make_packet(kind, &packet);
+    start = now();
+
+    for (long i = 0; i < OPS; i++) {
+        packet.seqnum = i;
+        sink += pkt_checksum(kind, &packet);
+    }
+
+    return (now() - start) * 1e9 / OPS;
+}
+
+static void report(const char *name, int kind) {
+    printf("%-20s %8.2f", name, cost(kind));
+
+    for (int e = 0; e < NERRORS; e++) {
+        printf(" %12.2e", undetected(kind, e));
+    }
+
+    printf("\n");
+}
+
+int main() {
+    int hardware = crc32c_hardware;
+
+    printf("%-20s %8s", "checksum", "ns/pkt");
+
+    for (int e = 0; e < NERRORS; e++) {
+        printf(" %12s", error_names[e]);
+    }
+
+    printf("\n%-20s %8s %s\n", "", "", "(fraction of corrupted packets not detected)");
+
+    report("legacy", CHECKSUM_LEGACY);
+    report("internet", CHECKSUM_INTERNET);
+
+    if (hardware) {
+        report("crc32c (sse4.2)", CHECKSUM_CRC32C);
+    }
+
+    crc32c_hardware = 0;
+    report("crc32c (portable)", CHECKSUM_CRC32C);
+
+    return 0;
+}
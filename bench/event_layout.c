@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../event_queue.h"
+#include "../pool.h"
+#include "bench.h"
+
+/*******************************************************************
+ Microbenchmark of the event record layout: packets flow through an
+ in-flight FIFO (as in tolayer3() and the main loop) and are handed to a
+ receiver, comparing the old layout (event + separately allocated packet,
+ copied field by field into pkt2give) with the packet stored inline.
+**********************************************************************/
+
+#define CYCLES  20000000L
+
+/* event layout before the packet was stored inline */
+struct split_event {
+    float evtime;
+    int evtype;
+    int eventity;
+    struct pkt *pktptr;
+    struct split_event *prev;
+    struct split_event *next;
+};
+
+/* volatile, so the deliveries are not optimized away */
+volatile int sink_checksum = 0;
+
+/**
+ * Faz o papel de A_input/B_input: recebe o pacote por valor
+ */
+__attribute__((noinline)) void deliver(struct pkt packet) {
+    sink_checksum += packet.seqnum + packet.checksum + packet.payload[0];
+}
+
+static void make_packet(struct pkt *packet, long i) {
+    packet->seqnum = (int)i;
+    packet->acknum = 0;
+    packet->checksum = (int)i;
+
+    for (int j = 0; j < 20; j++) {
+        packet->payload[j] = 'a' + i % 26;
+    }
+}
+
+/**
+ * Layout antigo; use_pool escolhe entre malloc/free e os pools
+ */
+static double run_split(int inflight, int use_pool) {
+    struct split_event *head = NULL, *tail = NULL, *ev;
+    struct pool event_pool, pkt_pool;
+    struct pkt packet, pkt2give;
+    double start = 0.0;
+
+    pool_init(&event_pool, sizeof(struct split_event), 256);
+    pool_init(&pkt_pool, sizeof(struct pkt), 256);
+
+    for (long i = 0; i < CYCLES + inflight; i++) {
+        /* deliver the oldest packet once the link is full */
+        if (i == inflight) {
+            start = now();
+        }
+
+        if (i >= inflight) {
+            ev = head;
+            head = head->next;
+
+            pkt2give.seqnum = ev->pktptr->seqnum;
+            pkt2give.acknum = ev->pktptr->acknum;
+            pkt2give.checksum = ev->pktptr->checksum;
+
+            for (int j = 0; j < 20; j++) {
+                pkt2give.payload[j] = ev->pktptr->payload[j];
+            }
+
+            deliver(pkt2give);
+
+            if (use_pool) {
+                pool_free(&pkt_pool, ev->pktptr);
+                pool_free(&event_pool, ev);
+            } else {
+                free(ev->pktptr);
+                free(ev);
+            }
+        }
+
+        make_packet(&packet, i);
+
+        if (use_pool) {
+            ev = pool_alloc(&event_pool);
+            ev->pktptr = pool_alloc(&pkt_pool);
+        } else {
+            ev = malloc(sizeof(struct split_event));
+            ev->pktptr = malloc(sizeof(struct pkt));
+        }
+
+        *ev->pktptr = packet;
+        ev->evtime = (float)i;
+        ev->evtype = 2;
+        ev->eventity = 1;
+        ev->next = NULL;
+        ev->prev = tail;
+
+        if (head == NULL) {
+            head = ev;
+        } else {
+            tail->next = ev;
+        }
+
+        tail = ev;
+    }
+
+    start = now() - start;
+
+    pool_destroy(&event_pool);
+    pool_destroy(&pkt_pool);
+
+    return CYCLES / start;
+}
+
+/**
+ * Layout atual: o pacote fica dentro do evento
+ */
+static double run_inline(int inflight) {
+    struct event *head = NULL, *tail = NULL, *ev;
+    struct pool event_pool;
+    struct pkt packet;
+    double start = 0.0;
+
+    pool_init(&event_pool, sizeof(struct event), 256);
+
+    for (long i = 0; i < CYCLES + inflight; i++) {
+        if (i == inflight) {
+            start = now();
+        }
+
+        if (i >= inflight) {
+            ev = head;
+            head = head->next;
+
+            deliver(ev->pkt);
+            pool_free(&event_pool, ev);
+        }
+
+        make_packet(&packet, i);
+
+        ev = pool_alloc(&event_pool);
+        ev->pkt = packet;
+        ev->evtime = (float)i;
+        ev->evtype = 2;
+        ev->eventity = 1;
+        ev->evseq = i;
+        ev->next = NULL;
+
+        if (head == NULL) {
+            head = ev;
+        } else {
+            tail->next = ev;
+        }
+
+        tail = ev;
+    }
+
+    start = now() - start;
+
+    pool_destroy(&event_pool);
+
+    return CYCLES / start;
+}
+
+int main() {
+    int inflight[] = { 8, 1024, 262144 };
+
+    printf("event record: split %zu + %zu bytes, inline %zu bytes\n",
+        sizeof(struct split_event), sizeof(struct pkt), sizeof(struct event));
+    printf("%10s %18s %18s %18s\n", "in flight", "split+malloc ev/s", "split+pool ev/s", "inline+pool ev/s");
+
+    for (int i = 0; i < 3; i++) {
+        double a = run_split(inflight[i], 0);
+        double b = run_split(inflight[i], 1);
+        double c = run_inline(inflight[i]);
+
+        printf("%10d %18.3e %18.3e %18.3e\n", inflight[i], a, b, c);
+    }
+
+    return 0;
+}
@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../checksum.h"
+#include "../replication.h"
+#include "bench.h"
+
+/*******************************************************************
+ Microbenchmarks of the simulator's hot paths (nextevent() over the
+ future event set, the in-flight FIFOs and the timers, the timers,
+ tolayer3(), the checksum and the Go-Back-N ACK path) and end-to-end
+ runs of each protocol at a fixed seed, in ns/op and ops/s. Results are
+ compared with a stored baseline (-b, by default bench/baseline.txt) and
+ written as the new baseline with -w. The hold test of the event queue
+ implementation alone is reported but kept out of the baseline.
+**********************************************************************/
+
+#define OPS                 10000000L
+#define REPEATS             3
+#define HOLD_EVENTS         1024
+#define INFLIGHT_PACKETS    8   /* per direction, a default window */
+#define DRAIN_EVERY         1024
+#define RUN_MESSAGES        200000
+#define SLOWER_THRESHOLD    0.10
+#define BASELINE            "bench/baseline.txt"
+#define MAX_RESULTS         16
+
+/* as in emulator.c */
+#define TIMER_INTERRUPT     0
+#define FROM_LAYER5         1
+#define FROM_LAYER3         2
+#define SENDER              0   /* entity A */
+#define RECEIVER            1   /* entity B */
+
+void insertevent(struct simulation *sim, struct event *p);
+struct event *nextevent(struct simulation *sim);
+
+/**
+ * Resultado de um benchmark: @name identifica a linha no baseline, e os que
+ * não têm @in_baseline só são informados
+ */
+struct bench_result {
+    const char *name;
+    const char *what;
+    double ns_per_op;
+    int in_baseline;
+};
+
+static struct bench_result results[MAX_RESULTS];
+static int nresults = 0;
+/* volatile, so the results are not optimized away */
+static volatile long long sink = 0;
+static FILE *devnull;
+
+/**
+ * Simulação sem trace e com a fila vazia (sem a primeira chegada da camada 5),
+ * para chamar as rotinas do emulador diretamente
+ */
+static void bench_sim(struct simulation *sim, const struct protocol *protocol) {
+    struct sim_config config;
+
+    config_defaults(&config);
+    config.given = CONFIG_PROMPTED;
+    config.nsimmax = 1;
+    config.lambda = 10;
+    config.rng_check = 0;
+
+    sim_init(sim, &config, protocol, devnull);
+    pool_free(&sim->event_pool, nextevent(sim));
+}
+
+static void record(const char *name, const char *what, double ns_per_op) {
+    results[nresults].name = name;
+    results[nresults].what = what;
+    results[nresults].ns_per_op = ns_per_op;
+    results[nresults].in_baseline = 1;
+    nresults++;
+}
+
+static void record_info(const char *name, const char *what, double ns_per_op) {
+    record(name, what, ns_per_op);
+    results[nresults - 1].in_baseline = 0;
+}
+
+/**
+ * Chegada de um pacote a @entity depois do último em trânsito para ela,
+ * como tolayer3() agenda
+ */
+static void schedule_arrival(struct simulation *sim, struct event *e, int entity) {
+    double last = sim->inflight_tail[entity] != NULL ? sim->inflight_tail[entity]->evtime : sim->time;
+
+    e->evtime = last + 1 + 9 * jimsrand(sim, STREAM_DELAY);
+    e->evtype = FROM_LAYER3;
+    e->eventity = entity;
+    insertevent(sim, e);
+}
+
+/**
+ * nextevent() no estado em que a simulação passa o tempo todo: só a próxima
+ * chegada da camada 5 na fila, INFLIGHT_PACKETS pacotes em trânsito em cada
+ * direção e o timer de A armado. Cada evento retirado é reagendado como o
+ * laço principal e os protocolos fariam.
+ */
+static double bench_nextevent() {
+    struct simulation sim;
+    struct event *e;
+    double start, elapsed;
+
+    bench_sim(&sim, &go_back_n_protocol);
+
+    e = pool_alloc(&sim.event_pool);
+    e->evtime = jimsrand(&sim, STREAM_ARRIVAL) * 2 * sim.lambda;
+    e->evtype = FROM_LAYER5;
+    e->eventity = SENDER;
+    insertevent(&sim, e);
+
+    for (int i = 0; i < INFLIGHT_PACKETS; i++) {
+        schedule_arrival(&sim, pool_alloc(&sim.event_pool), RECEIVER);
+        schedule_arrival(&sim, pool_alloc(&sim.event_pool), SENDER);
+    }
+
+    starttimer(&sim, SENDER, 50.0);
+    start = now();
+
+    for (long i = 0; i < OPS; i++) {
+        e = nextevent(&sim);
+        sim.time = e->evtime;
+
+        if (e->evtype == TIMER_INTERRUPT) {
+            starttimer(&sim, SENDER, 50.0);
+        } else if (e->evtype == FROM_LAYER3) {
+            schedule_arrival(&sim, e, e->eventity);
+        } else {
+            e->evtime = sim.time + jimsrand(&sim, STREAM_ARRIVAL) * 2 * sim.lambda;
+            insertevent(&sim, e);
+        }
+    }
+
+    elapsed = now() - start;
+    sim_destroy(&sim);
+
+    return elapsed * 1e9 / OPS;
+}
+
+/**
+ * Modelo "hold" da implementação da fila (--evqueue) sozinha: com
+ * HOLD_EVENTS eventos na fila, retira o próximo e o reinsere mais adiante.
+ * A simulação nunca tem mais que um evento na fila, então este teste fica
+ * fora do baseline.
+ */
+static double bench_hold() {
+    struct simulation sim;
+    double start, elapsed;
+
+    bench_sim(&sim, &go_back_n_protocol);
+
+    for (int i = 0; i < HOLD_EVENTS; i++) {
+        struct event *e = pool_alloc(&sim.event_pool);
+
+        e->evtime = jimsrand(&sim, STREAM_DELAY) * 2 * sim.lambda;
+        e->evtype = FROM_LAYER5;
+        e->eventity = SENDER;
+        insertevent(&sim, e);
+    }
+
+    start = now();
+
+    for (long i = 0; i < OPS; i++) {
+        struct event *e = nextevent(&sim);
+
+        sim.time = e->evtime;
+        e->evtime = sim.time + jimsrand(&sim, STREAM_DELAY) * 2 * sim.lambda;
+        insertevent(&sim, e);
+    }
+
+    elapsed = now() - start;
+    sim_destroy(&sim);
+
+    return elapsed * 1e9 / OPS;
+}
+
+static double bench_timer() {
+    struct simulation sim;
+    double start, elapsed;
+
+    bench_sim(&sim, &go_back_n_protocol);
+    start = now();
+
+    for (long i = 0; i < OPS; i++) {
+        starttimer(&sim, SENDER, 10.0 + (i & 7));
+        stoptimer(&sim, SENDER);
+    }
+
+    elapsed = now() - start;
+    sim_destroy(&sim);
+
+    return elapsed * 1e9 / OPS;
+}
+
+/**
+ * tolayer3() sem perdas nem corrupção, e a retirada do pacote da fila de
+ * trânsito pelo nextevent() (a cada DRAIN_EVERY envios)
+ */
+static double bench_tolayer3() {
+    struct simulation sim;
+    struct pkt packet = { 0 };
+    double start, elapsed;
+
+    bench_sim(&sim, &go_back_n_protocol);
+    start = now();
+
+    for (long i = 0; i < OPS; i++) {
+        packet.seqnum = i;
+        tolayer3(&sim, SENDER, packet);
+
+        if (i % DRAIN_EVERY == DRAIN_EVERY - 1) {
+            struct event *e;
+
+            while ((e = nextevent(&sim)) != NULL) {
+                sink += e->pkt.seqnum;
+                pool_free(&sim.event_pool, e);
+            }
+        }
+    }
+
+    elapsed = now() - start;
+    sim_destroy(&sim);
+
+    return elapsed * 1e9 / OPS;
+}
+
+static double bench_checksum() {
+    struct simulation sim;
+    struct pkt packet = { 0 };
+    double start, elapsed;
+
+    bench_sim(&sim, &go_back_n_protocol);
+    memcpy(packet.payload, "aaaaaaaaaaaaaaaaaaa", 20);
+    start = now();
+
+    for (long i = 0; i < OPS; i++) {
+        packet.seqnum = i;
+        sink += pkt_checksum(sim.config.checksum, &packet);
+    }
+
+    elapsed = now() - start;
+    sim_destroy(&sim);
+
+    return elapsed * 1e9 / OPS;
+}
+
+/**
+ * ACK do Go-Back-N pela interface do protocolo: com a janela cheia, A_output()
+ * põe uma mensagem no buffer e o ACK do pacote mais antigo, entregue a
+ * A_input(), desliza a janela e envia o próximo. Os pacotes enviados são
+ * retirados da fila de trânsito a cada DRAIN_EVERY ACKs, e o timer é rearmado.
+ */
+static double bench_gbn_ack() {
+    const struct protocol *gbn = &go_back_n_protocol;
+    struct simulation sim;
+    struct msg message;
+    struct pkt ack = { 0 };
+    double start, elapsed;
+
+    bench_sim(&sim, gbn);
+    memcpy(message.data, "aaaaaaaaaaaaaaaaaaa", 20);
+
+    for (int i = 0; i < INFLIGHT_PACKETS; i++) {
+        gbn->A_output(&sim, message);
+    }
+
+    start = now();
+
+    for (long i = 0; i < OPS; i++) {
+        sim.time++;
+        gbn->A_output(&sim, message);
+
+        ack.acknum = i + 1;
+        ack.checksum = pkt_checksum(sim.config.checksum, &ack);
+        gbn->A_input(&sim, ack);
+
+        if (i % DRAIN_EVERY == DRAIN_EVERY - 1) {
+            struct event *e;
+
+            while ((e = nextevent(&sim)) != NULL) {
+                if (e->evtype != TIMER_INTERRUPT) {
+                    sink += e->pkt.seqnum;
+                    pool_free(&sim.event_pool, e);
+                }
+            }
+
+            starttimer(&sim, SENDER, 50.0);
+        }
+    }
+
+    elapsed = now() - start;
+    sink += sim.ntolayer3;
+    sim_destroy(&sim);
+
+    return elapsed * 1e9 / OPS;
+}
+
+/**
+ * Execução completa, sem trace, com a semente padrão: ns por evento simulado
+ */
+static double bench_run(const struct protocol *protocol) {
+    struct sim_config config;
+    struct run_result result;
+
+    config_defaults(&config);
+    config.given = CONFIG_PROMPTED;
+    config.nsimmax = RUN_MESSAGES;
+    config.lossprob = 0.1;
+    config.corruptprob = 0.1;
+    config.lambda = 20;
+
+    run_simulation(&config, protocol, devnull, &result);
+    sink += result.ntolayer5;
+
+    return result.nevents > 0 ? result.wall_time * 1e9 / result.nevents : 0.0;
+}
+
+/**
+ * Menor tempo de REPEATS repetições, o menos afetado por ruído
+ */
+static double best_of(double (*bench)()) {
+    double best = bench();
+
+    for (int i = 1; i < REPEATS; i++) {
+        double t = bench();
+
+        if (t < best) {
+            best = t;
+        }
+    }
+
+    return best;
+}
+
+static double best_run(const struct protocol *protocol) {
+    double best = bench_run(protocol);
+
+    for (int i = 1; i < REPEATS; i++) {
+        double t = bench_run(protocol);
+
+        if (t < best) {
+            best = t;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * ns/op de @name no baseline, 0 se ele não estiver lá
+ */
+static double baseline_value(const char *path, const char *name) {
+    char key[64];
+    double value;
+    FILE *file = fopen(path, "r");
+
+    if (file == NULL) {
+        return 0.0;
+    }
+
+    while (fscanf(file, "%63s %lf", key, &value) == 2) {
+        if (strcmp(key, name) == 0) {
+            fclose(file);
+            return value;
+        }
+    }
+
+    fclose(file);
+
+    return 0.0;
+}
+
+static int write_baseline(const char *path) {
+    FILE *file = fopen(path, "w");
+
+    if (file == NULL) {
+        printf("unable to write baseline %s\n", path);
+        return 1;
+    }
+
+    for (int i = 0; i < nresults; i++) {
+        if (results[i].in_baseline) {
+            fprintf(file, "%s %.3f\n", results[i].name, results[i].ns_per_op);
+        }
+    }
+
+    fclose(file);
+    printf("\nbaseline written to %s\n", path);
+
+    return 0;
+}
+
+static void report(const char *baseline) {
+    int slower = 0, compared = 0;
+
+    printf("%-22s %-38s %10s %14s %10s %8s\n", "benchmark", "", "ns/op", "ops/s", "baseline", "change");
+
+    for (int i = 0; i < nresults; i++) {
+        const struct bench_result *r = &results[i];
+        double base = r->in_baseline ? baseline_value(baseline, r->name) : 0.0;
+
+        printf("%-22s %-38s %10.2f %14.0f", r->name, r->what, r->ns_per_op, 1e9 / r->ns_per_op);
+
+        if (base > 0) {
+            double change = r->ns_per_op / base - 1;
+
+            printf(" %10.2f %+7.1f%%%s", base, change * 100, change > SLOWER_THRESHOLD ? "  slower" : "");
+            slower += change > SLOWER_THRESHOLD;
+            compared++;
+        }
+
+        printf("\n");
+    }
+
+    if (slower > 0) {
+        printf("\n%d of %d benchmarks more than %.0f%% slower than %s\n",
+            slower, compared, SLOWER_THRESHOLD * 100, baseline);
+    }
+}
+
+static void usage(const char *prog) {
+    printf("usage: %s [-b baseline] [-w]\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    const char *baseline = BASELINE;
+    int write = 0, opt;
+
+    while ((opt = getopt(argc, argv, "b:w")) != -1) {
+        switch (opt) {
+        case 'b':
+            baseline = optarg;
+            break;
+        case 'w':
+            write = 1;
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    devnull = fopen("/dev/null", "w");
+
+    record("nextevent", "arrival, 2x8 in flight, timer running", best_of(bench_nextevent));
+    record("timer", "starttimer + stoptimer", best_of(bench_timer));
+    record("tolayer3", "no loss (with nextevent)", best_of(bench_tolayer3));
+    record("checksum", "pkt_checksum (legacy)", best_of(bench_checksum));
+    record("gbn_ack", "GBN A_output + A_input ACK, full window", best_of(bench_gbn_ack));
+    record("run_gbn", "200000 msgs, loss/corrupt 0.1 (event)", best_run(&go_back_n_protocol));
+    record("run_abp", "200000 msgs, loss/corrupt 0.1 (event)", best_run(&alternating_bit_protocol));
+    record("run_sr", "200000 msgs, loss/corrupt 0.1 (event)", best_run(&selective_repeat_protocol));
+    record_info("evqueue_hold", "queue only, 1024 events (not in baseline)", best_of(bench_hold));
+
+    report(baseline);
+    fclose(devnull);
+
+    if (write) {
+        return write_baseline(baseline);
+    }
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rng.h"
+#include "bench.h"
+
+/*******************************************************************
+ Microbenchmark of jimsrand()'s generators: nanoseconds per uniform
+ number drawn with the legacy rand() sequence (random_r, the per-
+ simulation equivalent) and with xoshiro256**, plus libc rand() itself.
+**********************************************************************/
+
+#define DRAWS   100000000L
+
+/* volatile, so the sums (and the draws) are not optimized away */
+volatile float sink = 0;
+
+static double run_rng(int kind) {
+    struct rng rng;
+    float sum = 0;
+    double start;
+
+    rng_seed(&rng, kind, 9999);
+    start = now();
+
+    for (long i = 0; i < DRAWS; i++) {
+        sum += rng_uniform(&rng);
+    }
+
+    sink += sum;
+
+    return (now() - start) * 1e9 / DRAWS;
+}
+
+static double run_rand() {
+    double mmm = RAND_MAX;
+    float sum = 0;
+    double start;
+
+    srand(9999);
+    start = now();
+
+    for (long i = 0; i < DRAWS; i++) {
+        sum += (float)(rand() / mmm);
+    }
+
+    sink += sum;
+
+    return (now() - start) * 1e9 / DRAWS;
+}
+
+int main() {
+    printf("%-10s %8.2f ns/number\n", "rand()", run_rand());
+    printf("%-10s %8.2f ns/number\n", rng_name(RNG_LEGACY), run_rng(RNG_LEGACY));
+    printf("%-10s %8.2f ns/number\n", rng_name(RNG_XOSHIRO), run_rng(RNG_XOSHIRO));
+
+    return 0;
+}
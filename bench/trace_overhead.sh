@@ -0,0 +1,43 @@
+#!/bin/sh
+#
+# Vazão do simulador com o trace como era antes (tudo impresso, TRACE=2),
+# desligado em tempo de execução (TRACE=0) e removido na compilação
+# (TRACE_MAX_LEVEL=0), e com o trace binário (-t). A saída vai para /dev/null.
+#
+set -e
+cd "$(dirname "$0")/.."
+
+EMULATOR="-pthread main.c emulator.c event_queue.c pool.c bintrace.c config.c rng.c rto.c replication.c stats.c histogram.c checksum.c"
+GBN="-DPROTOCOL=go_back_n_protocol go-back-n.c"
+ABP="-DPROTOCOL=alternating_bit_protocol alternating-bit-protocol.c"
+
+gcc -O2 -o bench/gbn-trace.out $GBN $EMULATOR -lm
+gcc -O2 -DTRACE_MAX_LEVEL=0 -o bench/gbn-notrace.out $GBN $EMULATOR -lm
+gcc -O2 -o bench/abp-trace.out $ABP $EMULATOR -lm
+gcc -O2 -DTRACE_MAX_LEVEL=0 -o bench/abp-notrace.out $ABP $EMULATOR -lm
+
+BINTRACE=bench/trace.bt
+
+# run <binário> <TRACE> <mensagens> <perda> <corrupção> <lambda> [opções]
+run() {
+    start=$(date +%s%N)
+    printf '%s\n%s\n%s\n%s\n%s\n' "$3" "$4" "$5" "$6" "$2" | "./bench/$1" $7 > /dev/null
+    end=$(date +%s%N)
+    ms=$(( (end - start) / 1000000 ))
+    [ "$ms" -gt 0 ] || ms=1
+    printf '%-16s TRACE=%s %-18s %8d ms %10d msgs/s\n' "$1" "$2" "$7" "$ms" $(( $3 * 1000 / ms ))
+}
+
+echo "Go-Back-N: 200000 msgs, no loss, lambda 10"
+run gbn-trace.out 2 200000 0 0 10
+run gbn-trace.out 0 200000 0 0 10
+run gbn-notrace.out 2 200000 0 0 10
+run gbn-notrace.out 0 200000 0 0 10 "-t $BINTRACE"
+
+echo "Alternating bit: 200000 msgs, loss 0.1, corruption 0.1, lambda 100"
+run abp-trace.out 2 200000 0.1 0.1 100
+run abp-trace.out 0 200000 0.1 0.1 100
+run abp-notrace.out 2 200000 0.1 0.1 100
+run abp-notrace.out 0 200000 0.1 0.1 100 "-t $BINTRACE"
+
+rm -f "$BINTRACE"
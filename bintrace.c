@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bintrace.h"
+
+/***********************************************/
+/*             BINARY EVENT TRACE              */
+/***********************************************/
+
+/**
+ * Abre o arquivo do trace e escreve o cabeçalho. Retorna 0 em caso de erro.
+ */
+int bintrace_open(struct bintrace *bt, const char *path) {
+    struct bintrace_header header;
+
+    bt->file = fopen(path, "wb");
+
+    if (bt->file == NULL) {
+        return 0;
+    }
+
+    bt->ring = malloc(BINTRACE_RING_RECORDS * sizeof(struct bintrace_record));
+
+    if (bt->ring == NULL) {
+        fclose(bt->file);
+        bt->file = NULL;
+        return 0;
+    }
+
+    /* the ring is the only buffering needed, it is always written whole */
+    setvbuf(bt->file, NULL, _IONBF, 0);
+
+    memcpy(header.magic, BINTRACE_MAGIC, sizeof(header.magic));
+    header.version = BINTRACE_VERSION;
+    header.record_size = sizeof(struct bintrace_record);
+    fwrite(&header, sizeof(header), 1, bt->file);
+
+    bt->used = 0;
+    bt->records = 0;
+
+    return 1;
+}
+
+void bintrace_flush(struct bintrace *bt) {
+    if (bt->file == NULL || bt->used == 0) {
+        return;
+    }
+
+    fwrite(bt->ring, sizeof(struct bintrace_record), bt->used, bt->file);
+    bt->records += bt->used;
+    bt->used = 0;
+}
+
+void bintrace_close(struct bintrace *bt) {
+    if (bt->file == NULL) {
+        return;
+    }
+
+    bintrace_flush(bt);
+    fclose(bt->file);
+    free(bt->ring);
+
+    bt->file = NULL;
+    bt->ring = NULL;
+}
@@ -0,0 +1,104 @@
+#ifndef BINTRACE_H
+#define BINTRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Trace binário: registros de tamanho fixo gravados num buffer em memória e
+ * escritos no arquivo em blocos grandes, sem formatar texto durante a
+ * simulação. O arquivo é convertido em texto por trace-decode.c.
+ *
+ * Arquivo: um struct bintrace_header seguido de registros struct bintrace_record
+ */
+
+#define BINTRACE_MAGIC          "RTPT"
+#define BINTRACE_VERSION        2
+#define BINTRACE_RING_RECORDS   8192
+
+/* record types: the first three are the simulated events (same codes as */
+/* the emulator's event types), the others calls made by the protocols */
+#define BT_TIMER_INTERRUPT  0   /* timer went off */
+#define BT_FROM_LAYER5      1   /* message arrived from layer 5 */
+#define BT_FROM_LAYER3      2   /* packet arrived from the medium */
+#define BT_TOLAYER3         3   /* packet handed to the medium */
+#define BT_TOLAYER5         4   /* data delivered to layer 5 */
+#define BT_START_TIMER      5   /* timer started */
+#define BT_STOP_TIMER       6   /* timer stopped */
+
+/* flags */
+#define BT_LOST             0x01    /* packet dropped by the medium */
+#define BT_CORRUPT          0x02    /* packet corrupted by the medium */
+
+struct bintrace_header {
+    char magic[4];
+    uint16_t version;
+    uint16_t record_size;
+};
+
+/**
+ * Um registro do trace (40 bytes; a versão 1 tinha tempo em float e
+ * seqnum/acknum de 32 bits, em 20 bytes)
+ *
+ * @time: tempo da simulação
+ * @aux: instante de chegada (BT_TOLAYER3) ou de expiração (BT_START_TIMER)
+ * @seqnum, @acknum: do pacote, quando houver (BT_FROM_LAYER3, BT_TOLAYER3)
+ * @type: BT_*
+ * @entity: entidade onde ocorre (A = 0, B = 1)
+ * @flags: BT_LOST, BT_CORRUPT
+ */
+struct bintrace_record {
+    double time;
+    double aux;
+    int64_t seqnum;
+    int64_t acknum;
+    uint8_t type;
+    uint8_t entity;
+    uint8_t flags;
+    uint8_t pad[5];
+};
+
+/**
+ * Estado do trace de uma simulação: @ring guarda até BINTRACE_RING_RECORDS
+ * registros antes de ser escrito em @file (NULL quando o trace está desligado)
+ */
+struct bintrace {
+    FILE *file;
+    struct bintrace_record *ring;
+    int used;
+    unsigned long records;
+};
+
+int bintrace_open(struct bintrace *bt, const char *path);
+void bintrace_flush(struct bintrace *bt);
+void bintrace_close(struct bintrace *bt);
+
+/**
+ * Grava um registro, se o trace estiver aberto. Inline para que, sem trace,
+ * o custo em cada evento seja um único teste.
+ */
+static inline void bintrace_log(struct bintrace *bt, int type, int entity, double t, double aux,
+                                int64_t seqnum, int64_t acknum, int flags) {
+    struct bintrace_record *r;
+
+    if (bt->file == NULL) {
+        return;
+    }
+
+    r = &bt->ring[bt->used];
+    r->time = t;
+    r->aux = aux;
+    r->seqnum = seqnum;
+    r->acknum = acknum;
+    r->type = type;
+    r->entity = entity;
+    r->flags = flags;
+    memset(r->pad, 0, sizeof(r->pad));
+
+    if (++bt->used == BINTRACE_RING_RECORDS) {
+        bintrace_flush(bt);
+    }
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include <string.h>
+#include <stdint.h>
+
+#include "checksum.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_X86          1
+#endif
+
+/***********************************************/
+/*               PACKET CHECKSUMS              */
+/***********************************************/
+
+#define CRC32C_POLY         0x82f63b78u   /* reflected Castagnoli polynomial */
+
+static const char *checksum_names[] = { "legacy", "internet", "crc32c" };
+
+static uint32_t crc32c_table[256];
+int crc32c_hardware = 0;
+
+const char *checksum_name(int kind) {
+    if (kind < CHECKSUM_LEGACY || kind > CHECKSUM_CRC32C) {
+        return "unknown";
+    }
+
+    return checksum_names[kind];
+}
+
+/**
+ * Converte o nome de um checksum para o código CHECKSUM_*, -1 se não existir
+ */
+int checksum_parse(const char *name) {
+    for (int i = CHECKSUM_LEGACY; i <= CHECKSUM_CRC32C; i++) {
+        if (strcmp(name, checksum_names[i]) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Monta a tabela do CRC-32C portátil e verifica se a CPU tem a instrução crc32
+ */
+__attribute__((constructor)) static void crc32c_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+
+        for (int bit = 0; bit < 8; bit++) {
+            crc = crc & 1 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        }
+
+        crc32c_table[i] = crc;
+    }
+
+#ifdef CRC32C_X86
+    __builtin_cpu_init();
+    crc32c_hardware = __builtin_cpu_supports("sse4.2") != 0;
+#endif
+}
+
+static uint32_t crc32c_portable(uint32_t crc, const unsigned char *p, size_t len) {
+    while (len-- > 0) {
+        crc = crc32c_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#ifdef CRC32C_X86
+/**
+ * CRC-32C com a instrução crc32 do SSE4.2, 8 bytes por vez
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32c_sse42(uint32_t crc, const unsigned char *p, size_t len) {
+    uint64_t crc64 = crc;
+
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t word;
+
+        memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+
+    crc = (uint32_t)crc64;
+
+    for (; len > 0; p++, len--) {
+        crc = _mm_crc32_u8(crc, *p);
+    }
+
+    return crc;
+}
+#endif
+
+/**
+ * CRC-32C de @len bytes, continuando de @crc (0 no início)
+ */
+uint32_t crc32c(uint32_t crc, const void *data, size_t len) {
+    crc = ~crc;
+
+#ifdef CRC32C_X86
+    if (crc32c_hardware) {
+        return ~crc32c_sse42(crc, data, len);
+    }
+#endif
+
+    return ~crc32c_portable(crc, data, len);
+}
+
+/**
+ * Soma em complemento de um das palavras de 16 bits, complementada
+ */
+static uint16_t internet_checksum(const unsigned char *p, size_t len) {
+    uint32_t sum = 0;
+
+    for (; len >= 2; p += 2, len -= 2) {
+        uint16_t word;
+
+        memcpy(&word, p, 2);
+        sum += word;
+    }
+
+    if (len > 0) {
+        sum += *p;
+    }
+
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+
+    return (uint16_t)~sum;
+}
+
+/**
+ * Checksums que cobrem os bytes do pacote (CHECKSUM_INTERNET e
+ * CHECKSUM_CRC32C); o CHECKSUM_LEGACY é calculado em pkt_checksum()
+ */
+int pkt_checksum_bytes(int kind, const struct pkt *packet) {
+    unsigned char bytes[CHECKSUM_BYTES];
+
+    memcpy(bytes, &packet->seqnum, sizeof(seqnum_t));
+    memcpy(bytes + sizeof(seqnum_t), &packet->acknum, sizeof(seqnum_t));
+    memcpy(bytes + 2 * sizeof(seqnum_t), packet->payload, 20);
+
+    if (kind == CHECKSUM_INTERNET) {
+        return internet_checksum(bytes, sizeof(bytes));
+    }
+
+    return (int)crc32c(0, bytes, sizeof(bytes));
+}
@@ -0,0 +1,46 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "emulator.h"
+
+/* packet checksums: */
+#define CHECKSUM_LEGACY     0   /* sum of seqnum, acknum and payload bytes (original) */
+#define CHECKSUM_INTERNET   1   /* ones' complement sum of 16-bit words (RFC 1071) */
+#define CHECKSUM_CRC32C     2   /* CRC-32C (Castagnoli), SSE4.2 when available */
+
+/* bytes covered by the checksum: seqnum, acknum and payload */
+#define CHECKSUM_BYTES      (2 * sizeof(seqnum_t) + 20)
+
+/* the CPU has the SSE4.2 crc32 instruction (set at startup; clearing it */
+/* forces the portable CRC-32C) */
+extern int crc32c_hardware;
+
+const char *checksum_name(int kind);
+int checksum_parse(const char *name);
+int pkt_checksum_bytes(int kind, const struct pkt *packet);
+uint32_t crc32c(uint32_t crc, const void *data, size_t len);
+
+/**
+ * Checksum @kind (CHECKSUM_*) de seqnum, acknum e payload de um pacote.
+ * O padrão fica inline: ele é calculado a cada pacote enviado e recebido.
+ */
+static inline int pkt_checksum(int kind, const struct pkt *packet) {
+    int checksum;
+
+    if (kind != CHECKSUM_LEGACY) {
+        return pkt_checksum_bytes(kind, packet);
+    }
+
+    checksum = (int)(packet->seqnum + packet->acknum);
+
+    for (int i = 0; i < 20; i++) {
+        checksum += packet->payload[i];
+    }
+
+    return checksum;
+}
+
+#endif
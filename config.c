@@ -0,0 +1,452 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <getopt.h>
+#include <limits.h>
+
+#include "checksum.h"
+#include "config.h"
+#include "event_queue.h"
+#include "rng.h"
+#include "rto.h"
+
+/***********************************************/
+/*             RUN CONFIGURATION               */
+/***********************************************/
+
+#define CONFIG_LINE_MAX     256
+#define DEFAULT_SEED        9999
+#define DEFAULT_BATCH_SIZE  1000
+
+/**
+ * Opções aceitas, com o mesmo nome na linha de comando (--nome ou a letra)
+ * e no arquivo de configuração (nome = valor)
+ */
+struct config_option {
+    const char *name;
+    int letter;
+    const char *arg;
+    const char *help;
+};
+
+static const struct config_option options[] = {
+    { "messages",       'n', "N",     "number of messages to simulate" },
+    { "loss",           'l', "P",     "packet loss probability" },
+    { "corrupt",        'c', "P",     "packet corruption probability" },
+    { "lambda",         'm', "T",     "average time between messages from sender's layer5" },
+    { "trace",          'v', "LEVEL", "trace level" },
+    { "seed",           's', "SEED",  "random number generator seed (default 9999)" },
+    { "rng",            'g', "NAME",  "random number generator: xoshiro (default) or legacy (rand())" },
+    { "window",         'w', "N",     "sender window size" },
+    { "buffer",         'b', "N",     "sender buffer size" },
+    { "rtt",            'r', "T",     "sender timeout (the initial one with --rto adaptive)" },
+    { "rto",            'a', "NAME",  "retransmission timeout: fixed (default) or adaptive (SRTT/RTTVAR, Karn, backoff)" },
+    { "checksum",       'C', "NAME",  "packet checksum: legacy (default), internet or crc32c" },
+    { "evqueue",        'e', "NAME",  "future event set: list, heap2, heap4 or calendar" },
+    { "max-time",       'T', "T",     "stop the simulation at time T" },
+    { "precision",      'p', "P",     "stop when the 95% CI of the metric is within P of its mean" },
+    { "metric",         'M', "NAME",  "metric for --precision: goodput (default) or latency" },
+    { "batch",          'B', "N",     "delivered messages per batch for --precision (default 1000)" },
+    { "warmup",         'W', "N",     "delivered messages discarded before the first batch (default one batch)" },
+    { "output",         'o', "FILE",  "write the simulator output to FILE" },
+    { "bintrace",       't', "FILE",  "write a binary event trace to FILE" },
+    { "summary",        'S', "FILE",  "write a machine-readable run summary to FILE" },
+    { "summary-format", 'F', "NAME",  "format of --summary: json (default) or csv" },
+    { "skip-rng-check", 'k', NULL,    "skip the random number generator test" },
+    { "replications",   'R', "N",     "run N independent replications and report confidence intervals" },
+    { "threads",        'j', "N",     "threads for the replications (default one per core)" },
+    { "config",         'f', "FILE",  "read options from FILE, one 'name = value' per line" },
+    { "help",           'h', NULL,    "show this message" },
+};
+
+#define NOPTIONS    (int)(sizeof(options) / sizeof(options[0]))
+
+void config_defaults(struct sim_config *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->seed = DEFAULT_SEED;
+    cfg->rng = RNG_XOSHIRO;
+    cfg->rto = RTO_FIXED;
+    cfg->checksum = CHECKSUM_LEGACY;
+    cfg->evqueue = EVQUEUE_IMPL;
+    cfg->rng_check = 1;
+    cfg->metric = METRIC_GOODPUT;
+    cfg->batch_size = DEFAULT_BATCH_SIZE;
+    cfg->warmup = -1;
+    cfg->replications = 1;
+}
+
+static int parse_int(const char *value, int min, int *out) {
+    char *end;
+    long v;
+
+    if (value == NULL) {
+        return 0;
+    }
+
+    v = strtol(value, &end, 10);
+
+    if (end == value || *end != '\0' || v < min) {
+        return 0;
+    }
+
+    *out = (int)v;
+    return 1;
+}
+
+static int parse_long(const char *value, long long min, long long *out) {
+    char *end;
+    long long v;
+
+    if (value == NULL) {
+        return 0;
+    }
+
+    v = strtoll(value, &end, 10);
+
+    if (end == value || *end != '\0' || v < min) {
+        return 0;
+    }
+
+    *out = v;
+    return 1;
+}
+
+static int parse_double(const char *value, double min, double max, double *out) {
+    char *end;
+    double v;
+
+    if (value == NULL) {
+        return 0;
+    }
+
+    v = strtod(value, &end);
+
+    if (end == value || *end != '\0' || v < min || v > max) {
+        return 0;
+    }
+
+    *out = v;
+    return 1;
+}
+
+/**
+ * Troca a cópia de uma string da configuração (a anterior é liberada)
+ */
+static int set_string(char **field, const char *value) {
+    free(*field);
+    *field = value != NULL ? strdup(value) : NULL;
+
+    return *field != NULL;
+}
+
+static int metric_parse(const char *name) {
+    if (strcmp(name, "goodput") == 0) {
+        return METRIC_GOODPUT;
+    }
+
+    if (strcmp(name, "latency") == 0) {
+        return METRIC_LATENCY;
+    }
+
+    return -1;
+}
+
+static int summary_format_parse(const char *name) {
+    if (strcmp(name, "json") == 0) {
+        return SUMMARY_JSON;
+    }
+
+    if (strcmp(name, "csv") == 0) {
+        return SUMMARY_CSV;
+    }
+
+    return -1;
+}
+
+/**
+ * Atribui uma opção pelo nome. Opções sem argumento aceitam valor NULL
+ * (linha de comando) ou 0/1 (arquivo). Retorna 0 se o nome ou o valor for inválido.
+ */
+int config_set(struct sim_config *cfg, const char *key, const char *value) {
+    int ok = 0, seed;
+
+    if (strcmp(key, "messages") == 0) {
+        ok = parse_long(value, 0, &cfg->nsimmax);
+        cfg->given |= CONFIG_MESSAGES;
+    } else if (strcmp(key, "loss") == 0) {
+        ok = parse_double(value, 0.0, 1.0, &cfg->lossprob);
+        cfg->given |= CONFIG_LOSS;
+    } else if (strcmp(key, "corrupt") == 0) {
+        ok = parse_double(value, 0.0, 1.0, &cfg->corruptprob);
+        cfg->given |= CONFIG_CORRUPT;
+    } else if (strcmp(key, "lambda") == 0) {
+        ok = parse_double(value, 0.0, 1e30, &cfg->lambda) && cfg->lambda > 0.0;
+        cfg->given |= CONFIG_LAMBDA;
+    } else if (strcmp(key, "trace") == 0) {
+        ok = parse_int(value, 0, &cfg->trace);
+        cfg->given |= CONFIG_TRACE;
+    } else if (strcmp(key, "seed") == 0) {
+        if ((ok = parse_int(value, 0, &seed))) {
+            cfg->seed = (unsigned int)seed;
+        }
+    } else if (strcmp(key, "rng") == 0) {
+        ok = value != NULL && (cfg->rng = rng_parse(value)) >= 0;
+    } else if (strcmp(key, "window") == 0) {
+        ok = parse_int(value, 0, &cfg->window_size);
+    } else if (strcmp(key, "buffer") == 0) {
+        ok = parse_int(value, 0, &cfg->buffer_size);
+    } else if (strcmp(key, "rtt") == 0) {
+        ok = parse_double(value, 0.0, 1e30, &cfg->rtt);
+    } else if (strcmp(key, "rto") == 0) {
+        ok = value != NULL && (cfg->rto = rto_parse(value)) >= 0;
+    } else if (strcmp(key, "checksum") == 0) {
+        ok = value != NULL && (cfg->checksum = checksum_parse(value)) >= 0;
+    } else if (strcmp(key, "max-time") == 0) {
+        ok = parse_double(value, 0.0, 1e30, &cfg->max_time);
+    } else if (strcmp(key, "precision") == 0) {
+        ok = parse_double(value, 0.0, 1.0, &cfg->precision);
+    } else if (strcmp(key, "metric") == 0) {
+        ok = value != NULL && (cfg->metric = metric_parse(value)) >= 0;
+    } else if (strcmp(key, "batch") == 0) {
+        ok = parse_int(value, 1, &cfg->batch_size);
+    } else if (strcmp(key, "warmup") == 0) {
+        ok = parse_int(value, 0, &cfg->warmup);
+    } else if (strcmp(key, "evqueue") == 0) {
+        ok = value != NULL && (cfg->evqueue = evq_parse(value)) >= 0;
+    } else if (strcmp(key, "output") == 0) {
+        ok = set_string(&cfg->output, value);
+    } else if (strcmp(key, "bintrace") == 0) {
+        ok = set_string(&cfg->bintrace, value);
+    } else if (strcmp(key, "summary") == 0) {
+        ok = set_string(&cfg->summary, value);
+    } else if (strcmp(key, "summary-format") == 0) {
+        ok = value != NULL && (cfg->summary_format = summary_format_parse(value)) >= 0;
+    } else if (strcmp(key, "replications") == 0) {
+        ok = parse_int(value, 1, &cfg->replications);
+    } else if (strcmp(key, "threads") == 0) {
+        ok = parse_int(value, 0, &cfg->threads);
+    } else if (strcmp(key, "skip-rng-check") == 0) {
+        cfg->rng_check = value != NULL && strcmp(value, "0") == 0;
+        ok = value == NULL || strcmp(value, "0") == 0 || strcmp(value, "1") == 0;
+    } else {
+        printf("unknown option %s\n", key);
+        return 0;
+    }
+
+    if (!ok) {
+        printf("invalid value for %s: %s\n", key, value != NULL ? value : "(none)");
+    }
+
+    return ok;
+}
+
+/**
+ * Remove os espaços do início e do fim de @s, no próprio buffer
+ */
+char *config_trim(char *s) {
+    char *end;
+
+    while (isspace((unsigned char)*s)) {
+        s++;
+    }
+
+    end = s + strlen(s);
+
+    while (end > s && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+
+    *end = '\0';
+
+    return s;
+}
+
+/**
+ * Separa uma linha 'nome = valor' de um arquivo de configuração (ou da grade
+ * do sweep), ignorando o comentário iniciado por '#'. @value fica NULL se a
+ * linha não tiver '='. Retorna 0 se a linha estiver vazia (ou só tiver comentário).
+ */
+int config_split_line(char *line, char **key, char **value) {
+    char *p;
+
+    if ((p = strchr(line, '#')) != NULL) {
+        *p = '\0';
+    }
+
+    *value = NULL;
+
+    if ((p = strchr(line, '=')) != NULL) {
+        *p = '\0';
+        *value = config_trim(p + 1);
+    }
+
+    *key = config_trim(line);
+
+    return **key != '\0' || *value != NULL;
+}
+
+/**
+ * Lê um arquivo de configuração: uma opção 'nome = valor' por linha, com
+ * comentários iniciados por '#'. Retorna 0 em caso de erro.
+ */
+int config_load(struct sim_config *cfg, const char *path) {
+    char line[CONFIG_LINE_MAX];
+    FILE *file = fopen(path, "r");
+    int lineno = 0;
+
+    if (file == NULL) {
+        printf("unable to open config file %s\n", path);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char *key, *value;
+
+        lineno++;
+
+        if (!config_split_line(line, &key, &value)) {
+            continue;
+        }
+
+        if (strcmp(key, "config") == 0 || strcmp(key, "help") == 0 || !config_set(cfg, key, value)) {
+            printf("%s:%d: invalid line\n", path, lineno);
+            fclose(file);
+            return 0;
+        }
+    }
+
+    fclose(file);
+
+    return 1;
+}
+
+static const struct config_option *find_option(int letter) {
+    for (int i = 0; i < NOPTIONS; i++) {
+        if (options[i].letter == letter) {
+            return &options[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void usage(const char *prog) {
+    printf("usage: %s [options]\n\n", prog);
+
+    for (int i = 0; i < NOPTIONS; i++) {
+        char left[32];
+
+        snprintf(left, sizeof(left), "-%c, --%s%s%s", options[i].letter, options[i].name,
+            options[i].arg ? " " : "", options[i].arg ? options[i].arg : "");
+        printf("  %-28s %s\n", left, options[i].help);
+    }
+
+    printf("\nmessages, loss, corrupt, lambda and trace not given are read from stdin\n");
+    printf("(with --precision, messages only caps the run and is not asked for).\n");
+    printf("Options are applied in order: the ones after -f override the file.\n");
+}
+
+/**
+ * Lê as opções da linha de comando, na ordem; -f carrega o arquivo no ponto
+ * em que aparece. Encerra o programa se alguma opção for inválida.
+ */
+void config_parse_args(struct sim_config *cfg, int argc, char **argv) {
+    struct option longopts[NOPTIONS + 1];
+    char shortopts[2 * NOPTIONS + 1];
+    char *s = shortopts;
+    int opt;
+
+    for (int i = 0; i < NOPTIONS; i++) {
+        longopts[i].name = options[i].name;
+        longopts[i].has_arg = options[i].arg ? required_argument : no_argument;
+        longopts[i].flag = NULL;
+        longopts[i].val = options[i].letter;
+
+        *s++ = options[i].letter;
+
+        if (options[i].arg) {
+            *s++ = ':';
+        }
+    }
+
+    memset(&longopts[NOPTIONS], 0, sizeof(struct option));
+    *s = '\0';
+
+    while ((opt = getopt_long(argc, argv, shortopts, longopts, NULL)) != -1) {
+        const struct config_option *o = find_option(opt);
+
+        if (o == NULL || opt == 'h') {
+            usage(argv[0]);
+            exit(opt == 'h' ? 0 : 1);
+        }
+
+        if (opt == 'f') {
+            if (!config_load(cfg, optarg)) {
+                exit(1);
+            }
+        } else if (!config_set(cfg, o->name, optarg)) {
+            exit(1);
+        }
+    }
+
+    if (optind < argc) {
+        usage(argv[0]);
+        exit(1);
+    }
+}
+
+/**
+ * Pergunta na entrada padrão, como o emulador original, os parâmetros que
+ * não foram informados
+ */
+void config_prompt(struct sim_config *cfg) {
+    /* with a target precision the run length is not known in advance */
+    if (cfg->precision > 0 && !(cfg->given & CONFIG_MESSAGES)) {
+        cfg->nsimmax = LLONG_MAX;
+        cfg->given |= CONFIG_MESSAGES;
+    }
+
+    if ((cfg->given & CONFIG_PROMPTED) == CONFIG_PROMPTED) {
+        return;
+    }
+
+    printf("-----  Stop and Wait Network Simulator Version 1.1 -------- \n\n");
+
+    if (!(cfg->given & CONFIG_MESSAGES)) {
+        printf("Enter the number of messages to simulate: ");
+        scanf("%lld", &cfg->nsimmax);
+    }
+
+    if (!(cfg->given & CONFIG_LOSS)) {
+        printf("Enter  packet loss probability [enter 0.0 for no loss]:");
+        scanf("%lf", &cfg->lossprob);
+    }
+
+    if (!(cfg->given & CONFIG_CORRUPT)) {
+        printf("Enter packet corruption probability [0.0 for no corruption]:");
+        scanf("%lf", &cfg->corruptprob);
+    }
+
+    if (!(cfg->given & CONFIG_LAMBDA)) {
+        printf("Enter average time between messages from sender's layer5 [ > 0.0]:");
+        scanf("%lf", &cfg->lambda);
+    }
+
+    if (!(cfg->given & CONFIG_TRACE)) {
+        printf("Enter TRACE:");
+        scanf("%d", &cfg->trace);
+    }
+
+    cfg->given |= CONFIG_PROMPTED;
+}
+
+/**
+ * Libera as strings copiadas por config_set
+ */
+void config_free(struct sim_config *cfg) {
+    free(cfg->output);
+    free(cfg->bintrace);
+    free(cfg->summary);
+    cfg->output = cfg->bintrace = cfg->summary = NULL;
+}
@@ -0,0 +1,91 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/* parameters that used to be read from stdin, in the original prompt order */
+#define CONFIG_MESSAGES     0x01
+#define CONFIG_LOSS         0x02
+#define CONFIG_CORRUPT      0x04
+#define CONFIG_LAMBDA       0x08
+#define CONFIG_TRACE        0x10
+#define CONFIG_PROMPTED     0x1f
+
+/* estimates that --precision can be asked for */
+#define METRIC_GOODPUT      0
+#define METRIC_LATENCY      1
+
+/* formats of the --summary file */
+#define SUMMARY_JSON        0
+#define SUMMARY_CSV         1
+
+/**
+ * Parâmetros de uma execução, vindos da linha de comando, de um arquivo de
+ * configuração ou (os que faltarem entre os da CONFIG_PROMPTED) da entrada padrão
+ *
+ * @nsimmax: número de mensagens a simular
+ * @lossprob, @corruptprob: probabilidades de perda e de corrupção de um pacote
+ * @lambda: tempo médio entre mensagens da camada 5
+ * @trace: nível de trace (TRACE)
+ * @seed: semente do gerador de números aleatórios
+ * @rng: gerador de números aleatórios (RNG_*)
+ * @window_size, @buffer_size: janela e buffer do remetente, 0 para o padrão do protocolo
+ * @rtt: timeout do remetente (o inicial, com RTO_ADAPTIVE), 0 para o padrão do protocolo
+ * @rto: política do timeout de retransmissão (RTO_*)
+ * @checksum: checksum dos pacotes (CHECKSUM_*)
+ * @evqueue: implementação do conjunto de eventos futuros (EVQ_*)
+ * @max_time: encerra a simulação neste instante, 0 para rodar até acabarem os eventos
+ * @output: arquivo para a saída do simulador, NULL para a saída padrão
+ * @bintrace: arquivo do trace binário, NULL para não gravar
+ * @summary: arquivo do resumo da execução para outros programas, NULL para não gravar
+ * @summary_format: formato de @summary (SUMMARY_*)
+ * @rng_check: faz o teste do gerador de números aleatórios no início
+ * @precision: encerra a simulação quando o intervalo de confiança de 95% de
+ *             @metric for menor que esta fração da média, 0 para não encerrar
+ * @metric: estimativa controlada por @precision (METRIC_*)
+ * @batch_size: mensagens entregues por lote nas médias por lote
+ * @warmup: mensagens entregues descartadas no início, -1 para um lote
+ * @replications: número de replicações independentes (1 para uma execução só)
+ * @threads: threads que executam as replicações, 0 para uma por núcleo
+ * @given: parâmetros da CONFIG_PROMPTED já informados
+ */
+struct sim_config {
+    long long nsimmax;
+    double lossprob;
+    double corruptprob;
+    double lambda;
+    int trace;
+
+    unsigned int seed;
+    int rng;
+    int window_size;
+    int buffer_size;
+    double rtt;
+    int rto;
+    int checksum;
+    int evqueue;
+    double max_time;
+    double precision;
+    int metric;
+    int batch_size;
+    int warmup;
+
+    char *output;
+    char *bintrace;
+    char *summary;
+    int summary_format;
+    int rng_check;
+    int replications;
+    int threads;
+
+    int given;
+};
+
+void config_defaults(struct sim_config *cfg);
+int config_set(struct sim_config *cfg, const char *key, const char *value);
+int config_load(struct sim_config *cfg, const char *path);
+int config_split_line(char *line, char **key, char **value);
+char *config_trim(char *s);
+void config_parse_args(struct sim_config *cfg, int argc, char **argv);
+void config_prompt(struct sim_config *cfg);
+void config_free(struct sim_config *cfg);
+
+#endif
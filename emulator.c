@@ -0,0 +1,737 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bintrace.h"
+#include "checksum.h"
+#include "config.h"
+#include "emulator.h"
+#include "event_queue.h"
+#include "pool.h"
+#include "simulation.h"
+#include "trace.h"
+
+/***********************************************/
+/*     NETWORK EMULATION CODE STARTS BELOW      */
+/***********************************************/
+
+/* events (with their packet copy) are recycled instead of malloc'ed */
+#define POOL_SLAB_OBJS     256
+
+/* initial room for accepted messages not yet delivered (it doubles when full) */
+#define PENDING_INITIAL    64
+
+/* resolution of the per-message histograms, in simulated time units */
+#define LATENCY_UNIT       0.001
+
+/* batches needed before the precision of a batch-means estimate is trusted */
+#define BATCH_MIN          10
+
+/* possible events: */
+#define TIMER_INTERRUPT    0
+#define FROM_LAYER5        1
+#define FROM_LAYER3        2
+
+#define OFF                0
+#define ON                 1
+#define A                  0
+#define B                  1
+
+void generate_next_arrival(struct simulation *sim);
+void insertevent(struct simulation *sim, struct event *p);
+struct event *nextevent(struct simulation *sim);
+static void pending_push(struct simulation *sim);
+static void pending_pop(struct simulation *sim);
+static void print_batch_means(struct simulation *sim);
+static void print_latency(struct simulation *sim);
+
+/**
+ * Executa a simulação até acabarem os eventos
+ */
+void sim_run(struct simulation *sim) {
+    const struct protocol *proto = sim->protocol;
+    struct event *eventptr;
+    struct msg  msg2give;
+    struct timespec start, end;
+
+    int i,j;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (1) {
+        /* the estimate asked with --precision is good enough */
+        if (sim->converged) {
+            goto terminate;
+        }
+
+        /* get next event to simulate */
+        eventptr = nextevent(sim);
+
+        if (eventptr == NULL) {
+            goto terminate;
+        }
+
+        /* a protocol that never settles (or a huge run) is cut at max_time */
+        if (sim->config.max_time > 0 && eventptr->evtime > sim->config.max_time) {
+            if (eventptr->evtype != TIMER_INTERRUPT) {
+                pool_free(&sim->event_pool, eventptr);
+            }
+
+            sim->stopped = 1;
+            goto terminate;
+        }
+
+        if (TRACE_ON(sim, TRACE_EVENTS)) {
+            fprintf(sim->log, "\nEVENT time: %f,", eventptr->evtime);
+            fprintf(sim->log, "  type: %d", eventptr->evtype);
+
+            if (eventptr->evtype == 0) {
+                fprintf(sim->log, ", timerinterrupt  ");
+            } else if (eventptr->evtype == 1) {
+                fprintf(sim->log, ", fromlayer5 ");
+            } else {
+                fprintf(sim->log, ", fromlayer3 ");
+            }
+
+            fprintf(sim->log, " entity: %d\n", eventptr->eventity);
+        }
+
+        /* update time to next event time */
+        sim->time = eventptr->evtime;
+        sim->nevents++;
+
+        if (eventptr->evtype == FROM_LAYER3) {
+            bintrace_log(&sim->bintrace, eventptr->evtype, eventptr->eventity, sim->time, 0,
+                eventptr->pkt.seqnum, eventptr->pkt.acknum, 0);
+        } else {
+            bintrace_log(&sim->bintrace, eventptr->evtype, eventptr->eventity, sim->time, 0, 0, 0, 0);
+        }
+
+        if (eventptr->evtype == FROM_LAYER5 && sim->nsim < sim->nsimmax) {
+            /* set up future arrival */
+            if (sim->nsim + 1 < sim->nsimmax) {
+                generate_next_arrival(sim);
+            }
+
+            /* fill in msg to give with string of same letter */
+            j = sim->nsim % 26;
+            for (i = 0; i < 20; i++) {
+                msg2give.data[i] = 97 + j;
+            }
+            msg2give.data[19] = 0;
+
+            if (TRACE_ON(sim, TRACE_DEBUG)) {
+                fprintf(sim->log, "          MAINLOOP: data given to student: ");
+
+                for (i = 0; i < 20; i++) {
+                    fprintf(sim->log, "%c", msg2give.data[i]);
+                }
+
+               fprintf(sim->log, "\n");
+	        }
+
+            sim->nsim++;
+
+            if (eventptr->eventity == A) {
+                /* stamped before A_output, which may already send it */
+                pending_push(sim);
+
+                if (proto->A_output(sim, msg2give)) {
+                    sim->naccepted++;
+                } else {
+                    pending_pop(sim);
+                }
+            } else {
+                proto->B_output(sim, msg2give);
+            }
+        } else if (eventptr->evtype == FROM_LAYER3) {
+            /* deliver packet (stored in the event) by calling */
+            if (eventptr->eventity == A) {
+                proto->A_input(sim, eventptr->pkt);
+            } else {
+                proto->B_input(sim, eventptr->pkt);
+            }
+        } else if (eventptr->evtype == TIMER_INTERRUPT) {
+            if (eventptr->eventity == A) {
+                /* only the sender's retransmission timer (B's may be a NAK timer) */
+                sim->ntimeout++;
+                proto->A_timerinterrupt(sim);
+            } else {
+                proto->B_timerinterrupt(sim);
+            }
+        } else {
+	        fprintf(sim->log, "INTERNAL PANIC: unknown event type \n");
+        }
+
+        /* timer events belong to their entity and are reused */
+        if (eventptr->evtype != TIMER_INTERRUPT) {
+            pool_free(&sim->event_pool, eventptr);
+        }
+    }
+
+    terminate:
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        sim->wall_time = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+        if (sim->stopped) {
+            fprintf(sim->log, "\nSimulator stopped at max time %f after sending %lld msgs from layer5\n", sim->config.max_time, sim->nsim);
+        } else if (sim->converged) {
+            fprintf(sim->log, "\nSimulator stopped at time %f after sending %lld msgs from layer5: %s within %g%%\n",
+                sim->time, sim->nsim, sim->config.metric == METRIC_LATENCY ? "latency" : "goodput",
+                sim->config.precision * 100);
+        } else {
+            fprintf(sim->log, "\nSimulator terminated at time %f after sending %lld msgs from layer5\n", sim->time, sim->nsim);
+        }
+
+        print_latency(sim);
+
+        if (sim->config.precision > 0) {
+            print_batch_means(sim);
+        }
+
+        if (TRACE_ON(sim, TRACE_EVENTS)) {
+            pool_print_stats(sim->log, "event", &sim->event_pool);
+        }
+
+        bintrace_flush(&sim->bintrace);
+}
+
+/***********************************************/
+/*           INITIALIZE THE SIMULATOR          */
+/***********************************************/
+
+/**
+ * Prepara uma simulação com os parâmetros de @config (já completos) e
+ * inicializa o protocolo. Retorna 0 em caso de erro, já informado em @log.
+ */
+int sim_init(struct simulation *sim, const struct sim_config *config,
+             const struct protocol *protocol, FILE *log) {
+    int i;
+    float sum, avg;
+
+    memset(sim, 0, sizeof(*sim));
+    sim->config = *config;
+    sim->protocol = protocol;
+    sim->log = log;
+
+    sim->nsimmax = config->nsimmax;
+    sim->lossprob = config->lossprob;
+    sim->corruptprob = config->corruptprob;
+    sim->lambda = config->lambda;
+    sim->trace = config->trace;
+
+    if (config->bintrace != NULL && !bintrace_open(&sim->bintrace, config->bintrace)) {
+        fprintf(log, "unable to open trace file %s\n", config->bintrace);
+        return 0;
+    }
+
+    /* init random number generators: with RNG_LEGACY a single srand()/rand() */
+    /* sequence; otherwise one stream per source, 2^128 numbers apart */
+    rng_seed(&sim->rng[0], config->rng, config->seed);
+
+    for (i = 0; i < NSTREAMS; i++) {
+        if (config->rng == RNG_LEGACY) {
+            sim->stream[i] = &sim->rng[0];
+            continue;
+        }
+
+        if (i > 0) {
+            sim->rng[i] = sim->rng[i - 1];
+            rng_jump(&sim->rng[i]);
+        }
+
+        sim->stream[i] = &sim->rng[i];
+    }
+
+    /* test random number generator for students (it draws 1000 numbers, */
+    /* so skipping it changes the rest of the random sequence) */
+    if (config->rng_check) {
+        sum = (float)0.0;
+
+        for (i = 0; i < 1000; i++) {
+            /* jimsrand() should be uniform in [0,1] */
+            sum = sum + jimsrand(sim, STREAM_ARRIVAL);
+        }
+
+        avg = sum / (float)1000.0;
+
+        if (avg < 0.25 || avg > 0.75) {
+            fprintf(log, "It is likely that random number generation on your machine\n" );
+            fprintf(log, "is different from what this emulator expects.  Please take\n");
+            fprintf(log, "a look at the routine jimsrand() in the emulator code. Sorry. \n");
+            bintrace_close(&sim->bintrace);
+            return 0;
+        }
+    }
+
+    sim->ntolayer3 = 0;
+    sim->nlost = 0;
+    sim->ncorrupt = 0;
+    sim->ntolayer5 = 0;
+
+    /* initialize time to 0.0 */
+    sim->time = 0.0;
+
+    /* initialize event queue (EVQUEUE_IMPL unless --evqueue was given) */
+    evq_init(&sim->evqueue, config->evqueue);
+    pool_init(&sim->event_pool, sizeof(struct event), POOL_SLAB_OBJS);
+    sim->timer_running[A] = OFF;
+    sim->timer_running[B] = OFF;
+    sim->inflight_head[A] = sim->inflight_tail[A] = NULL;
+    sim->inflight_head[B] = sim->inflight_tail[B] = NULL;
+    generate_next_arrival(sim);
+
+    batch_init(&sim->batches, config->batch_size,
+        config->warmup >= 0 ? config->warmup : config->batch_size);
+    hist_init(&sim->latency, LATENCY_UNIT);
+    hist_init(&sim->buffer_wait, LATENCY_UNIT);
+    hist_init(&sim->retransmissions, 1);
+
+    sim->protocol_state = calloc(1, protocol->state_size);
+    protocol->A_init(sim);
+    protocol->B_init(sim);
+
+    return 1;
+}
+
+/**
+ * Libera tudo o que a simulação alocou (o log continua aberto)
+ */
+void sim_destroy(struct simulation *sim) {
+    if (sim->protocol->destroy != NULL) {
+        sim->protocol->destroy(sim);
+    }
+
+    free(sim->protocol_state);
+    free(sim->pending);
+    hist_destroy(&sim->latency);
+    hist_destroy(&sim->buffer_wait);
+    hist_destroy(&sim->retransmissions);
+    evq_destroy(&sim->evqueue);
+    pool_destroy(&sim->event_pool);
+    bintrace_close(&sim->bintrace);
+}
+
+/***********************************************/
+/*           RANDOM GENERATOR ROUTINE          */
+/***********************************************/
+
+float jimsrand(struct simulation *sim, int stream) {
+    /* x should be uniform in [0,1] */
+    return rng_uniform(sim->stream[stream]);
+}
+
+/***********************************************/
+/*           EVENT HANDLINE ROUTINES           */
+/***********************************************/
+
+void generate_next_arrival(struct simulation *sim) {
+    double x;
+    struct event *evptr;
+
+    if (TRACE_ON(sim, TRACE_DEBUG)) {
+        fprintf(sim->log, "          GENERATE NEXT ARRIVAL: creating new arrival\n");
+    }
+
+    /* x is uniform on [0,2*lambda] */
+    /* having mean of lambda        */
+    x = sim->lambda * jimsrand(sim, STREAM_ARRIVAL) * 2;
+
+    evptr = (struct event *)pool_alloc(&sim->event_pool);
+    evptr->evtime = sim->time + x;
+    evptr->evtype = FROM_LAYER5;
+
+    if (BIDIRECTIONAL && (jimsrand(sim, STREAM_ARRIVAL) > 0.5)) {
+        evptr->eventity = B;
+    } else {
+        evptr->eventity = A;
+    }
+
+    insertevent(sim, evptr);
+}
+
+void insertevent(struct simulation *sim, struct event *p) {
+    if (TRACE_ON(sim, TRACE_DEBUG)) {
+        fprintf(sim->log, "            INSERTEVENT: time is %lf\n", sim->time);
+        fprintf(sim->log, "            INSERTEVENT: future time will be %lf\n", p->evtime);
+    }
+
+    /* events with the same evtime are simulated in insertion order */
+    p->evseq = sim->evseq++;
+
+    if (p->evtype != FROM_LAYER3) {
+        evq_push(&sim->evqueue, p);
+        return;
+    }
+
+    /* tolayer3() never schedules an arrival before the direction's tail */
+    p->next = NULL;
+
+    if (sim->inflight_tail[p->eventity] == NULL) {
+        sim->inflight_head[p->eventity] = p;
+    } else {
+        sim->inflight_tail[p->eventity]->next = p;
+    }
+
+    sim->inflight_tail[p->eventity] = p;
+}
+
+/**
+ * Remove e retorna o próximo evento: o primeiro da fila, um dos timers ou o
+ * primeiro pacote em trânsito de uma das direções, o que ocorrer antes
+ */
+struct event *nextevent(struct simulation *sim) {
+    struct event *next = evq_peek(&sim->evqueue);
+    struct event *head;
+    int i;
+
+    for (i = A; i <= B; i++) {
+        if (sim->timer_running[i] && (next == NULL || event_before(&sim->timers[i], next))) {
+            next = &sim->timers[i];
+        }
+
+        head = sim->inflight_head[i];
+
+        if (head != NULL && (next == NULL || event_before(head, next))) {
+            next = head;
+        }
+    }
+
+    if (next == NULL) {
+        return NULL;
+    }
+
+    if (next->evtype == TIMER_INTERRUPT) {
+        sim->timer_running[next->eventity] = OFF;
+    } else if (next->evtype == FROM_LAYER3) {
+        sim->inflight_head[next->eventity] = next->next;
+
+        if (next->next == NULL) {
+            sim->inflight_tail[next->eventity] = NULL;
+        }
+    } else {
+        evq_pop(&sim->evqueue);
+    }
+
+    return next;
+}
+
+void printevlist(struct simulation *sim) {
+    struct event *q;
+    struct evq_iter it;
+    int i;
+
+    fprintf(sim->log, "--------------\nEvent List Follows (%s, unordered):\n", evq_name(sim->evqueue.impl));
+
+    for (q = evq_first(&sim->evqueue, &it); q != NULL; q = evq_next(&sim->evqueue, &it)) {
+        fprintf(sim->log, "Event time: %f, type: %d entity: %d\n", q->evtime, q->evtype, q->eventity);
+    }
+
+    for (i = A; i <= B; i++) {
+        if (sim->timer_running[i]) {
+            fprintf(sim->log, "Event time: %f, type: %d entity: %d\n", sim->timers[i].evtime, sim->timers[i].evtype, sim->timers[i].eventity);
+        }
+
+        for (q = sim->inflight_head[i]; q != NULL; q = q->next) {
+            fprintf(sim->log, "Event time: %f, type: %d entity: %d\n", q->evtime, q->evtype, q->eventity);
+        }
+    }
+
+    fprintf(sim->log, "--------------\n");
+}
+
+/**
+ * Guarda o instante em que chegou a mensagem entregue ao remetente, para
+ * medir o atraso quando ela for entregue (as entregas seguem a ordem de
+ * aceitação). Fica no máximo o buffer do remetente na fila, então a memória
+ * não cresce com a duração da simulação.
+ */
+static void pending_push(struct simulation *sim) {
+    struct pending_msg *msg;
+    int i;
+
+    if (sim->pending_count == sim->pending_capacity) {
+        int capacity = sim->pending_capacity > 0 ? 2 * sim->pending_capacity : PENDING_INITIAL;
+        struct pending_msg *pending = malloc(capacity * sizeof(struct pending_msg));
+
+        if (pending == NULL) {
+            printf("INTERNAL PANIC: out of memory growing the pending messages\n");
+            exit(1);
+        }
+
+        for (i = 0; i < sim->pending_count; i++) {
+            pending[i] = sim->pending[(sim->pending_head + i) % sim->pending_capacity];
+        }
+
+        free(sim->pending);
+        sim->pending = pending;
+        sim->pending_head = 0;
+        sim->pending_capacity = capacity;
+    }
+
+    msg = &sim->pending[(sim->pending_head + sim->pending_count) % sim->pending_capacity];
+    msg->arrival = sim->time;
+    msg->first_sent = -1;
+    msg->retransmissions = 0;
+    sim->pending_count++;
+}
+
+/**
+ * Desfaz o último pending_push(), de uma mensagem que o remetente rejeitou
+ */
+static void pending_pop(struct simulation *sim) {
+    sim->pending_count--;
+}
+
+/**
+ * Registro da mensagem número @msg (na ordem de aceitação), NULL se ela
+ * já foi entregue
+ */
+static struct pending_msg *pending_find(struct simulation *sim, long long msg) {
+    long long offset = msg - sim->pending_first;
+
+    if (offset < 0 || offset >= sim->pending_count) {
+        return NULL;
+    }
+
+    return &sim->pending[(sim->pending_head + offset) % sim->pending_capacity];
+}
+
+/**
+ * Confere, a cada lote fechado, se o intervalo de confiança da estimativa
+ * pedida já é estreito o bastante
+ */
+static void check_precision(struct simulation *sim) {
+    const struct summary *s = sim->config.metric == METRIC_LATENCY ? &sim->batches.latency : &sim->batches.goodput;
+
+    if (s->n < BATCH_MIN || s->mean <= 0) {
+        return;
+    }
+
+    if (summary_ci95(s) <= sim->config.precision * s->mean) {
+        sim->converged = 1;
+    }
+}
+
+static void print_histogram_row(FILE *log, const char *name, const struct histogram *h) {
+    fprintf(log, "  %-16s %12f %12f %12f %12f %12f\n", name, hist_mean(h),
+        hist_percentile(h, 0.5), hist_percentile(h, 0.99), hist_percentile(h, 0.999), h->max);
+}
+
+/**
+ * Distribuição, por mensagem entregue, do atraso, da espera no buffer do
+ * remetente e dos reenvios
+ */
+static void print_latency(struct simulation *sim) {
+    if (sim->latency.count == 0) {
+        return;
+    }
+
+    fprintf(sim->log, "Per-message latency (%lld msgs delivered):\n", sim->latency.count);
+    fprintf(sim->log, "  %-16s %12s %12s %12s %12s %12s\n", "", "mean", "p50", "p99", "p99.9", "max");
+    print_histogram_row(sim->log, "end to end", &sim->latency);
+
+    if (sim->buffer_wait.count > 0) {
+        print_histogram_row(sim->log, "buffer wait", &sim->buffer_wait);
+    }
+
+    print_histogram_row(sim->log, "retransmissions", &sim->retransmissions);
+}
+
+static void print_batch_means(struct simulation *sim) {
+    const struct batch_means *b = &sim->batches;
+
+    fprintf(sim->log, "Batch means (%ld batches of %ld msgs after %ld warm-up msgs):\n",
+        b->latency.n, b->size, b->warmup);
+    fprintf(sim->log, "  goodput %f +- %f, latency %f +- %f (95%% CI)\n",
+        b->goodput.mean, summary_ci95(&b->goodput), b->latency.mean, summary_ci95(&b->latency));
+}
+
+/***********************************************/
+/*          STUDENT-CALLABLE ROUTINES          */
+/***********************************************/
+
+void stoptimer(struct simulation *sim, int AorB) {
+    if (TRACE_ON(sim, TRACE_DEBUG)) {
+        fprintf(sim->log, "          STOP TIMER: stopping timer at %f\n", sim->time);
+    }
+
+    if (!sim->timer_running[AorB]) {
+        /* protocol misuse: reported at every trace level */
+        fprintf(sim->log, "Warning: unable to cancel your timer. It wasn't running.\n");
+        return;
+    }
+
+    sim->timer_running[AorB] = OFF;
+    bintrace_log(&sim->bintrace, BT_STOP_TIMER, AorB, sim->time, 0, 0, 0, 0);
+}
+
+void starttimer(struct simulation *sim, int AorB, double increment) {
+    struct event *evptr = &sim->timers[AorB];
+
+    if (TRACE_ON(sim, TRACE_DEBUG)) {
+        fprintf(sim->log, "          START TIMER: starting timer at %f\n", sim->time);
+    }
+
+    /* be nice: check to see if timer is already started, if so, then warn */
+    if (sim->timer_running[AorB]) {
+        fprintf(sim->log, "Warning: attempt to start a timer that is already started\n");
+        return;
+    }
+
+    /* arm the entity's timer event for when timer goes off */
+    evptr->evtime = sim->time + increment;
+    evptr->evtype = TIMER_INTERRUPT;
+    evptr->eventity = AorB;
+    evptr->evseq = sim->evseq++;
+
+    sim->timer_running[AorB] = ON;
+    bintrace_log(&sim->bintrace, BT_START_TIMER, AorB, sim->time, evptr->evtime, 0, 0, 0);
+}
+
+void tolayer3(struct simulation *sim, int AorB, struct pkt packet) {
+    struct pkt *mypktptr;
+    struct event *evptr;
+    double lastime;
+    float x;
+    int i, flags = 0;
+
+    sim->ntolayer3++;
+
+    /* simulate losses: */
+    if (jimsrand(sim, STREAM_LOSS) < sim->lossprob) {
+        sim->nlost++;
+        bintrace_log(&sim->bintrace, BT_TOLAYER3, AorB, sim->time, 0, packet.seqnum, packet.acknum, BT_LOST);
+
+        if (TRACE_ON(sim, TRACE_PROTOCOL)) {
+            fprintf(sim->log, "          TOLAYER3: packet being lost\n");
+        }
+
+        return;
+    }
+
+    /* create future event for arrival of packet at the other side, with a */
+    /* copy of the packet student just gave me since he/she may decide */
+    /* to do something with the packet after we return back to him/her */
+    evptr = (struct event *)pool_alloc(&sim->event_pool);
+    evptr->evtype = FROM_LAYER3;    /* packet will pop out from layer3 */
+    evptr->eventity = (AorB + 1) % 2;   /* event occurs at other entity */
+    evptr->pkt = packet;
+    mypktptr = &evptr->pkt;
+
+    if (TRACE_ON(sim, TRACE_DEBUG)) {
+        fprintf(sim->log, "          TOLAYER3: seq: %lld, ack %lld, check: %d ", mypktptr->seqnum, mypktptr->acknum, mypktptr->checksum);
+
+        for (i = 0; i < 20; i++) {
+            fprintf(sim->log, "%c", mypktptr->payload[i]);
+        }
+
+        fprintf(sim->log, "\n");
+    }
+
+    /* finally, compute the arrival time of packet at the other end.
+    medium can not reorder, so make sure packet arrives between 1 and 10
+    time units after the latest arrival time of packets
+    currently in the medium on their way to the destination */
+
+    lastime = sim->time;
+
+    /* the latest arrival is the tail of the direction's in-flight FIFO */
+    if (sim->inflight_tail[evptr->eventity] != NULL) {
+        lastime = sim->inflight_tail[evptr->eventity]->evtime;
+    }
+
+    evptr->evtime = lastime + 1 + 9 * jimsrand(sim, STREAM_DELAY);
+
+    /* simulate corruption: */
+    if (jimsrand(sim, STREAM_CORRUPT) < sim->corruptprob) {
+        sim->ncorrupt++;
+        flags = BT_CORRUPT;
+
+        if ((x = jimsrand(sim, STREAM_CORRUPT)) < .75) {
+            mypktptr->payload[0] = 'Z'; /* corrupt payload */
+        } else if (x < .875) {
+            mypktptr->seqnum = 999999;
+        } else {
+            mypktptr->acknum = 999999;
+        }
+
+        /* every protocol checks the packets with the --checksum algorithm */
+        if (pkt_checksum(sim->config.checksum, mypktptr) == mypktptr->checksum) {
+            sim->nundetected++;
+        }
+
+        if (TRACE_ON(sim, TRACE_PROTOCOL)) {
+            fprintf(sim->log, "          TOLAYER3: packet being corrupted\n");
+        }
+    }
+
+    if (TRACE_ON(sim, TRACE_DEBUG)) {
+        fprintf(sim->log, "          TOLAYER3: scheduling arrival on other side\n");
+    }
+
+    bintrace_log(&sim->bintrace, BT_TOLAYER3, AorB, sim->time, evptr->evtime, packet.seqnum, packet.acknum, flags);
+
+    insertevent(sim, evptr);
+}
+
+/**
+ * Chamada pelo protocolo a cada pacote de dados que A envia com a mensagem
+ * número @msg (0 para a primeira que ele aceitou); @retransmission diz se ela
+ * já tinha sido enviada. Envios de mensagens já entregues só são contados
+ * em sim->nretransmit.
+ */
+void data_sent(struct simulation *sim, long long msg, int retransmission) {
+    struct pending_msg *pending = pending_find(sim, msg);
+
+    sim->ndata++;
+
+    if (retransmission) {
+        sim->nretransmit++;
+    }
+
+    if (pending == NULL) {
+        return;
+    }
+
+    if (retransmission) {
+        pending->retransmissions++;
+    } else if (pending->first_sent < 0) {
+        pending->first_sent = sim->time;
+        hist_add(&sim->buffer_wait, sim->time - pending->arrival);
+    }
+}
+
+void tolayer5(struct simulation *sim, int AorB, char datasent[20]) {
+    int i;
+
+    sim->ntolayer5++;
+    bintrace_log(&sim->bintrace, BT_TOLAYER5, AorB, sim->time, 0, 0, 0, 0);
+
+    /* the oldest accepted message is the one being delivered */
+    if (AorB == B && sim->pending_count > 0) {
+        const struct pending_msg *msg = &sim->pending[sim->pending_head];
+        double latency = sim->time - msg->arrival;
+
+        hist_add(&sim->latency, latency);
+        hist_add(&sim->retransmissions, msg->retransmissions);
+
+        if (sim->config.precision > 0 && batch_add(&sim->batches, sim->time, latency)) {
+            check_precision(sim);
+        }
+
+        sim->pending_head = (sim->pending_head + 1) % sim->pending_capacity;
+        sim->pending_count--;
+        sim->pending_first++;
+    }
+
+    if (TRACE_ON(sim, TRACE_DEBUG)) {
+        fprintf(sim->log, "          TOLAYER5: data received: ");
+
+        for (i = 0; i < 20; i++) {
+            fprintf(sim->log, "%c", datasent[i]);
+        }
+
+        fprintf(sim->log, "\n");
+    }
+}
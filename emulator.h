@@ -0,0 +1,76 @@
+#ifndef EMULATOR_H
+#define EMULATOR_H
+
+/*******************************************************************
+ ALTERNATING BIT AND GO-BACK-N NETWORK EMULATOR: VERSION 1.1  J.F.Kurose
+
+   Interface shared by the protocol implementations (go-back-n.c,
+   alternating-bit-protocol.c, selective-repeat.c) and the network
+   emulator (emulator.c).
+   Every routine receives the simulation it belongs to, so several
+   simulations can run at the same time in one process.
+**********************************************************************/
+
+#include <stddef.h>
+
+#define BIDIRECTIONAL 0
+
+/* sequence and ack numbers, wide enough for runs of billions of packets */
+typedef long long seqnum_t;
+
+struct msg {
+    char data[20];
+};
+
+struct pkt {
+    seqnum_t seqnum;
+    seqnum_t acknum;
+    int checksum;
+    char payload[20];
+};
+
+struct simulation;
+
+/**
+ * Rotinas do emulador que o protocolo pode chamar. Além de enviar cada pacote
+ * de dados com tolayer3, o remetente informa com data_sent qual mensagem ele
+ * leva e se é um reenvio, para as estatísticas de atraso e de reenvios; o
+ * receptor que usa NAKs os conta em sim->nnak.
+ */
+void starttimer(struct simulation *sim, int AorB, double increment);
+void stoptimer(struct simulation *sim, int AorB);
+void tolayer3(struct simulation *sim, int AorB, struct pkt packet);
+void tolayer5(struct simulation *sim, int AorB, char datasent[20]);
+void data_sent(struct simulation *sim, long long msg, int retransmission);
+
+/**
+ * Rotinas que cada protocolo implementa e que o emulador chama, reunidas numa
+ * tabela para que mais de um protocolo possa ser ligado no mesmo programa
+ *
+ * @name: nome do protocolo
+ * @state_size: tamanho do estado do protocolo, alocado (zerado) pelo emulador
+ *              em sim->protocol_state antes de A_init e B_init
+ * @A_output, @B_output: retornam 1 se a mensagem foi aceita (e será entregue,
+ *                       em ordem), 0 se foi descartada
+ * @destroy: libera o que A_init e B_init alocaram (NULL se não houver nada)
+ */
+struct protocol {
+    const char *name;
+    size_t state_size;
+
+    void (*A_init)(struct simulation *sim);
+    int (*A_output)(struct simulation *sim, struct msg message);
+    void (*A_input)(struct simulation *sim, struct pkt packet);
+    void (*A_timerinterrupt)(struct simulation *sim);
+    void (*B_init)(struct simulation *sim);
+    int (*B_output)(struct simulation *sim, struct msg message);
+    void (*B_input)(struct simulation *sim, struct pkt packet);
+    void (*B_timerinterrupt)(struct simulation *sim);
+    void (*destroy)(struct simulation *sim);
+};
+
+extern const struct protocol go_back_n_protocol;
+extern const struct protocol alternating_bit_protocol;
+extern const struct protocol selective_repeat_protocol;
+
+#endif
@@ -0,0 +1,446 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "event_queue.h"
+
+/***********************************************/
+/*      FUTURE EVENT SET (PRIORITY QUEUE)      */
+/***********************************************/
+
+#define HEAP_INITIAL_CAPACITY   64
+#define CALENDAR_MIN_BUCKETS    2
+#define CALENDAR_SAMPLES        25
+
+static const char *evq_names[] = { "list", "heap2", "heap4", "calendar" };
+
+const char *evq_name(int impl) {
+    if (impl < EVQ_LIST || impl > EVQ_CALENDAR) {
+        return "unknown";
+    }
+
+    return evq_names[impl];
+}
+
+/**
+ * Converte o nome de uma implementação para o código EVQ_*, -1 se não existir
+ */
+int evq_parse(const char *name) {
+    for (int i = EVQ_LIST; i <= EVQ_CALENDAR; i++) {
+        if (strcmp(name, evq_names[i]) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/***********************************************/
+/*                SORTED LIST                  */
+/***********************************************/
+
+/**
+ * Insere o evento depois de todos os que vêm antes dele (eventos com o mesmo
+ * evtime ficam em ordem de chegada)
+ */
+static void list_insert(struct event **head, struct event *p) {
+    struct event *q, *qold = NULL;
+
+    for (q = *head; q != NULL && !event_before(p, q); q = q->next) {
+        qold = q;
+    }
+
+    p->next = q;
+
+    if (qold == NULL) {
+        *head = p;
+    } else {
+        qold->next = p;
+    }
+}
+
+/**
+ * Os eventos só saem do início das listas, então elas são simplesmente encadeadas
+ */
+static struct event *list_pop(struct event **head) {
+    struct event *p = *head;
+
+    *head = p->next;
+
+    return p;
+}
+
+/***********************************************/
+/*                 D-ARY HEAP                  */
+/***********************************************/
+
+static inline void heap_sift_up(struct event_queue *q, int i, int d) {
+    struct event *e = q->heap[i];
+
+    while (i > 0) {
+        int parent = (i - 1) / d;
+
+        if (!event_before(e, q->heap[parent])) {
+            break;
+        }
+
+        q->heap[i] = q->heap[parent];
+        i = parent;
+    }
+
+    q->heap[i] = e;
+}
+
+static inline void heap_sift_down(struct event_queue *q, int i, int d) {
+    struct event *e = q->heap[i];
+
+    while (1) {
+        int first = d * i + 1;
+        int last = first + d;
+        int best = first;
+
+        if (first >= q->size) {
+            break;
+        }
+
+        if (last > q->size) {
+            last = q->size;
+        }
+
+        for (int c = first + 1; c < last; c++) {
+            if (event_before(q->heap[c], q->heap[best])) {
+                best = c;
+            }
+        }
+
+        if (!event_before(q->heap[best], e)) {
+            break;
+        }
+
+        q->heap[i] = q->heap[best];
+        i = best;
+    }
+
+    q->heap[i] = e;
+}
+
+/**
+ * As funções de sift recebem a aridade como constante para o compilador
+ * especializar os laços de cada variante
+ */
+static void heap_up(struct event_queue *q, int i) {
+    if (q->impl == EVQ_HEAP2) {
+        heap_sift_up(q, i, 2);
+    } else {
+        heap_sift_up(q, i, 4);
+    }
+}
+
+static void heap_down(struct event_queue *q, int i) {
+    if (q->impl == EVQ_HEAP2) {
+        heap_sift_down(q, i, 2);
+    } else {
+        heap_sift_down(q, i, 4);
+    }
+}
+
+static void heap_push(struct event_queue *q, struct event *e) {
+    if (q->size == q->capacity) {
+        q->capacity = q->capacity ? 2 * q->capacity : HEAP_INITIAL_CAPACITY;
+        q->heap = realloc(q->heap, q->capacity * sizeof(struct event *));
+    }
+
+    q->heap[q->size] = e;
+    q->size++;
+    heap_up(q, q->size - 1);
+}
+
+static struct event *heap_pop(struct event_queue *q) {
+    struct event *e = q->heap[0];
+
+    q->size--;
+
+    if (q->size > 0) {
+        q->heap[0] = q->heap[q->size];
+        heap_down(q, 0);
+    }
+
+    return e;
+}
+
+/***********************************************/
+/*               CALENDAR QUEUE                */
+/***********************************************/
+
+/**
+ * Dia virtual de um instante: contando dias desde o tempo 0, sem dar a volta
+ * no calendário. O dia no calendário é o dia virtual módulo nbuckets.
+ */
+static inline long long calendar_day(const struct event_queue *q, double t) {
+    return (long long)floor(t / q->width);
+}
+
+static inline struct event **calendar_bucket(struct event_queue *q, long long day) {
+    return &q->buckets[day % q->nbuckets];
+}
+
+static void calendar_insert(struct event_queue *q, struct event *e) {
+    long long day = calendar_day(q, e->evtime);
+
+    list_insert(calendar_bucket(q, day), e);
+
+    /* an event may be scheduled before the day the search stopped at (the */
+    /* queue was peeked but another source's event ran first), rewind to it */
+    if (day < q->current) {
+        q->current = day;
+    }
+}
+
+/**
+ * Encontra o próximo evento, avançando o dia corrente até achar um dia com
+ * evento no ano corrente. Se um ano inteiro passar vazio, busca direto o menor.
+ */
+static struct event *calendar_find(struct event_queue *q) {
+    struct event *best = NULL;
+
+    if (q->size == 0) {
+        return NULL;
+    }
+
+    for (int n = 0; n < q->nbuckets; n++, q->current++) {
+        struct event *e = *calendar_bucket(q, q->current);
+
+        if (e != NULL && calendar_day(q, e->evtime) <= q->current) {
+            return e;
+        }
+    }
+
+    for (int i = 0; i < q->nbuckets; i++) {
+        struct event *e = q->buckets[i];
+
+        if (e != NULL && (best == NULL || event_before(e, best))) {
+            best = e;
+        }
+    }
+
+    q->current = calendar_day(q, best->evtime);
+
+    return best;
+}
+
+static struct event *calendar_take(struct event_queue *q) {
+    struct event *e = calendar_find(q);
+
+    if (e != NULL) {
+        list_pop(calendar_bucket(q, calendar_day(q, e->evtime)));
+        q->size--;
+        q->lastprio = e->evtime;
+    }
+
+    return e;
+}
+
+/**
+ * Estima a largura do dia a partir da separação média entre os próximos
+ * eventos, ignorando separações muito maiores que a média (Brown, 1988)
+ */
+static double calendar_estimate_width(struct event_queue *q) {
+    struct event *sample[CALENDAR_SAMPLES];
+    long long current = q->current;
+    double lastprio = q->lastprio;
+    double avg, sum = 0.0;
+    int n = q->size < CALENDAR_SAMPLES ? q->size : CALENDAR_SAMPLES;
+    int used = 0;
+
+    if (n < 2) {
+        return q->width;
+    }
+
+    for (int i = 0; i < n; i++) {
+        sample[i] = calendar_take(q);
+    }
+
+    for (int i = 0; i < n; i++) {
+        calendar_insert(q, sample[i]);
+        q->size++;
+    }
+
+    q->current = current;
+    q->lastprio = lastprio;
+
+    avg = (sample[n - 1]->evtime - sample[0]->evtime) / (double)(n - 1);
+
+    if (avg <= 0.0) {
+        return q->width;
+    }
+
+    for (int i = 1; i < n; i++) {
+        double separation = sample[i]->evtime - sample[i - 1]->evtime;
+
+        if (separation <= 2.0 * avg) {
+            sum += separation;
+            used++;
+        }
+    }
+
+    if (used > 0 && sum > 0.0) {
+        avg = sum / used;
+    }
+
+    return 3.0 * avg;
+}
+
+static void calendar_resize(struct event_queue *q, int nbuckets) {
+    struct event **old = q->buckets;
+    int oldn = q->nbuckets;
+
+    if (q->resizing) {
+        return;
+    }
+
+    q->resizing = 1;
+    q->width = calendar_estimate_width(q);
+    q->buckets = calloc(nbuckets, sizeof(struct event *));
+    q->nbuckets = nbuckets;
+
+    for (int i = 0; i < oldn; i++) {
+        struct event *e = old[i];
+
+        while (e != NULL) {
+            struct event *next = e->next;
+            calendar_insert(q, e);
+            e = next;
+        }
+    }
+
+    free(old);
+
+    q->current = calendar_day(q, q->lastprio);
+    q->resizing = 0;
+}
+
+static void calendar_push(struct event_queue *q, struct event *e) {
+    calendar_insert(q, e);
+    q->size++;
+
+    if (q->size > 2 * q->nbuckets) {
+        calendar_resize(q, 2 * q->nbuckets);
+    }
+}
+
+static void calendar_shrink(struct event_queue *q) {
+    if (q->nbuckets > CALENDAR_MIN_BUCKETS && q->size < q->nbuckets / 2) {
+        calendar_resize(q, q->nbuckets / 2);
+    }
+}
+
+/***********************************************/
+/*                  INTERFACE                  */
+/***********************************************/
+
+void evq_init(struct event_queue *q, int impl) {
+    memset(q, 0, sizeof(*q));
+    q->impl = impl;
+
+    if (impl == EVQ_CALENDAR) {
+        q->nbuckets = CALENDAR_MIN_BUCKETS;
+        q->buckets = calloc(q->nbuckets, sizeof(struct event *));
+        q->width = 1.0;
+    }
+}
+
+/**
+ * Libera as estruturas da fila (os eventos continuam sendo do chamador)
+ */
+void evq_destroy(struct event_queue *q) {
+    free(q->heap);
+    free(q->buckets);
+    memset(q, 0, sizeof(*q));
+}
+
+void evq_push(struct event_queue *q, struct event *e) {
+    switch (q->impl) {
+    case EVQ_LIST:
+        list_insert(&q->head, e);
+        q->size++;
+        break;
+    case EVQ_CALENDAR:
+        calendar_push(q, e);
+        break;
+    default:
+        heap_push(q, e);
+        break;
+    }
+}
+
+struct event *evq_peek(struct event_queue *q) {
+    if (q->size == 0) {
+        return NULL;
+    }
+
+    switch (q->impl) {
+    case EVQ_LIST:
+        return q->head;
+    case EVQ_CALENDAR:
+        return calendar_find(q);
+    default:
+        return q->heap[0];
+    }
+}
+
+struct event *evq_pop(struct event_queue *q) {
+    struct event *e;
+
+    if (q->size == 0) {
+        return NULL;
+    }
+
+    switch (q->impl) {
+    case EVQ_LIST:
+        e = list_pop(&q->head);
+        q->size--;
+        break;
+    case EVQ_CALENDAR:
+        e = calendar_take(q);
+        calendar_shrink(q);
+        break;
+    default:
+        e = heap_pop(q);
+        break;
+    }
+
+    return e;
+}
+
+struct event *evq_first(struct event_queue *q, struct evq_iter *it) {
+    it->index = -1;
+    it->cur = NULL;
+
+    if (q->impl == EVQ_LIST) {
+        it->cur = q->head;
+        return it->cur;
+    }
+
+    return evq_next(q, it);
+}
+
+struct event *evq_next(struct event_queue *q, struct evq_iter *it) {
+    switch (q->impl) {
+    case EVQ_LIST:
+        it->cur = it->cur != NULL ? it->cur->next : NULL;
+        break;
+    case EVQ_CALENDAR:
+        it->cur = it->cur != NULL ? it->cur->next : NULL;
+
+        while (it->cur == NULL && ++it->index < q->nbuckets) {
+            it->cur = q->buckets[it->index];
+        }
+        break;
+    default:
+        it->index++;
+        it->cur = it->index < q->size ? q->heap[it->index] : NULL;
+        break;
+    }
+
+    return it->cur;
+}
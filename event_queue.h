@@ -0,0 +1,89 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include "emulator.h"
+
+/* 72 bytes: the packet (if any) is stored in the event itself, so */
+/* delivering it needs no copy and no second pointer to follow */
+struct event {
+    double evtime;          /* event time */
+    short evtype;           /* event type code */
+    short eventity;         /* entity where event occurs */
+    unsigned long evseq;    /* insertion order, breaks ties on evtime (FIFO) */
+    struct event *next;     /* in-flight FIFO, list and calendar buckets */
+    struct pkt pkt;         /* packet (if any) assoc w/ this event */
+};
+
+/* available future-event set implementations: */
+#define EVQ_LIST           0   /* sorted doubly-linked list, O(n) insert */
+#define EVQ_HEAP2          1   /* binary heap */
+#define EVQ_HEAP4          2   /* 4-ary heap */
+#define EVQ_CALENDAR       3   /* calendar queue (R. Brown, 1988) */
+
+#ifndef EVQUEUE_IMPL
+#define EVQUEUE_IMPL       EVQ_HEAP4
+#endif
+
+/**
+ * Conjunto de eventos futuros, ordenado por (evtime, evseq)
+ *
+ * @impl: implementação escolhida (EVQ_*)
+ * @size: número de eventos na fila
+ * @head: início da lista (EVQ_LIST)
+ * @heap: vetor do heap, com @capacity posições (EVQ_HEAP2, EVQ_HEAP4)
+ * @buckets: um dia do calendário por posição, cada um uma lista ordenada (EVQ_CALENDAR)
+ * @nbuckets: número de dias do calendário
+ * @width: duração de cada dia
+ * @current: dia virtual (ano * nbuckets + dia) em que a busca está
+ * @lastprio: evtime do último evento removido
+ * @resizing: desabilita o redimensionamento enquanto o calendário é reconstruído
+ */
+struct event_queue {
+    int impl;
+    int size;
+
+    struct event *head;
+
+    struct event **heap;
+    int capacity;
+
+    struct event **buckets;
+    int nbuckets;
+    double width;
+    long long current;
+    double lastprio;
+    int resizing;
+};
+
+/**
+ * Posição de uma iteração sobre a fila (sem ordem definida, exceto em EVQ_LIST)
+ */
+struct evq_iter {
+    int index;
+    struct event *cur;
+};
+
+/**
+ * Ordem dos eventos: pelo tempo e, em caso de empate, pela ordem de inserção
+ */
+static inline int event_before(const struct event *a, const struct event *b) {
+    if (a->evtime != b->evtime) {
+        return a->evtime < b->evtime;
+    }
+
+    return a->evseq < b->evseq;
+}
+
+const char *evq_name(int impl);
+int evq_parse(const char *name);
+
+void evq_init(struct event_queue *q, int impl);
+void evq_destroy(struct event_queue *q);
+void evq_push(struct event_queue *q, struct event *e);
+struct event *evq_peek(struct event_queue *q);
+struct event *evq_pop(struct event_queue *q);
+
+struct event *evq_first(struct event_queue *q, struct evq_iter *it);
+struct event *evq_next(struct event_queue *q, struct evq_iter *it);
+
+#endif
@@ -1,175 +1,207 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#define BIDIRECTIONAL 0
-
-struct msg {
-    char data[20];
-};
-
-struct pkt {
-    int seqnum;
-    int acknum;
-    int checksum;
-    char payload[20];
-};
+#include "checksum.h"
+#include "emulator.h"
+#include "rto.h"
+#include "simulation.h"
+#include "trace.h"
 
 /***********************************************/
 /*    STUDENTS WRITE THE NEXT SEVEN ROUTINES   */
 /***********************************************/
 
+/* valores usados quando --rtt, --window e --buffer não são informados */
 #define RTT                 50.0
 #define SENDER_WINDOW_SIZE  8
 #define SENDER_BUFFER_SIZE  25
 
-/**
- * Estrutura útil para saber se o pacote já foi enviado para o meio
- * 
- * @packet: estrutura do pacote
- * @sent: 1 se já foi enviado; 0 se ainda não foi;
- */
-struct pkt_controller {
-    struct pkt packet;
-    int sent;
-};
+/* number of the message a packet carries (seqnums start at 1, one per message) */
+#define MESSAGE(seqnum)     ((seqnum) - 1)
 
 /**
  * Estrutura do remetente
  * 
- * @rtt: Delay de transmissão, estático nessa simulação
- * @pkt_window_size: Tamanho da janela, estático nessa simulação
+ * O buffer é circular: o pacote de seqnum s fica na posição s % pkt_buffer_capacity,
+ * e os pacotes no buffer são sempre os de seqnum base até next_seqnum - 1.
+ * Os pacotes de base até next_to_send - 1 já foram enviados para o meio.
+ * 
+ * @rto: Timeout de retransmissão (fixo ou estimado, --rto)
+ * @pkt_window_size: Tamanho da janela, definido no início da simulação
+ * @base: Seqnum do pacote mais antigo no buffer, ainda sem ACK
  * @next_seqnum: Contador para controlar o seqnum do próximo pacote adicionado no buffer
+ * @next_to_send: Seqnum do primeiro pacote do buffer que ainda não foi enviado
  * @pkt_buffer_current_size: Contador para controlar o número de pacotes no buffer
- * @pkt_buffer: Vetor de pkt_controller, que armazena o pacote e se ele já foi enviado
+ * @pkt_buffer_capacity: Número de posições do buffer, definido no início da simulação
+ * @pkt_buffer: Buffer circular com os pacotes
+ * @sent_at: Instante do envio de cada pacote do buffer (mesma posição), negativo
+ *           se ele foi reenviado e por isso não serve de amostra de RTT (regra de Karn)
+ * @last_nak, @last_nak_time: Último NAK atendido e quando, para ignorar os repetidos
  */
 struct remetente {
-    float rtt;
+    struct rto rto;
     int pkt_window_size;
-    int next_seqnum;
+    seqnum_t base;
+    seqnum_t next_seqnum;
+    seqnum_t next_to_send;
     int pkt_buffer_current_size;
-    struct pkt_controller pkt_buffer[SENDER_BUFFER_SIZE];
-} A;
+    int pkt_buffer_capacity;
+    struct pkt *pkt_buffer;
+    double *sent_at;
+    seqnum_t last_nak;
+    double last_nak_time;
+};
 
 /**
  * Estrutura do receptor
  * 
+ * Manda um NAK só uma vez por lacuna: os pacotes seguintes que chegam fora de
+ * ordem enquanto o timer do NAK corre são descartados sem outro NAK.
+ * 
  * @expected_seqnum: Número de sequência do pacote esperado
+ * @nak_seqnum: Seqnum pedido no último NAK, enquanto o timer do NAK corre (0 se nenhum)
+ * @nak_timeout: Tempo até permitir um novo NAK para a mesma lacuna
  */
 struct receptor {
-    int expected_seqnum;
-} B;
+    seqnum_t expected_seqnum;
+    seqnum_t nak_seqnum;
+    double nak_timeout;
+};
 
 /**
- * Definição das funções que o código vai usar para evitar warning na compilação
+ * Estado do protocolo em uma simulação (sim->protocol_state)
  */
-void starttimer(int AorB, float increment);
-void stoptimer(int AorB);
-void tolayer3(int AorB, struct pkt packet);
-void tolayer5(int AorB, char datasent[20]);
+struct go_back_n {
+    struct remetente A;
+    struct receptor B;
+};
 
-/**
- * Atualiza checksum de um pacote somando seqnum, acknum e payload
- */
-void update_pkt_checksum(struct pkt *packet) {
-    int checksum = packet->seqnum + packet->acknum;
+static inline struct remetente *sender(struct simulation *sim) {
+    return &((struct go_back_n *)sim->protocol_state)->A;
+}
 
-    for (int i = 0; i < 20; i++) {
-        checksum += packet->payload[i];
-    }
+static inline struct receptor *receiver(struct simulation *sim) {
+    return &((struct go_back_n *)sim->protocol_state)->B;
+}
 
-    packet->checksum = checksum;
+/**
+ * Atualiza checksum de um pacote com o algoritmo de --checksum
+ */
+static void update_pkt_checksum(struct simulation *sim, struct pkt *packet) {
+    packet->checksum = pkt_checksum(sim->config.checksum, packet);
 }
 
 /**
  * Verifica se o checksum do pacote é igual ao checksum esperado
  */
-int is_valid_checksum(int expected_checksum, struct pkt *packet) {
-    int checksum = packet->seqnum + packet->acknum;
-
-    for (int i = 0; i < 20; i++) {
-        checksum += packet->payload[i];
-    }
-
-    return (checksum == expected_checksum);
+static int is_valid_checksum(struct simulation *sim, int expected_checksum, struct pkt *packet) {
+    return pkt_checksum(sim->config.checksum, packet) == expected_checksum;
 }
 
 /**
  * Envia ACK para o meio
  */
-void send_ACK(int AorB, int seqnum) {
-    struct pkt packet;
+static void send_ACK(struct simulation *sim, int AorB, seqnum_t seqnum) {
+    struct pkt packet = { 0 };
     packet.acknum = seqnum;
-    update_pkt_checksum(&packet);
+    update_pkt_checksum(sim, &packet);
 
-    printf("[send_ACK] Enviando (acknum: %d)\n", seqnum);
-    tolayer3(AorB, packet);
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[send_ACK] Enviando (acknum: %lld)\n", seqnum);
+    tolayer3(sim, AorB, packet);
 }
 
 /**
  * Envia NAK para o meio
  */
-void send_NAK(int AorB, int seqnum) {
-    struct pkt packet;
+static void send_NAK(struct simulation *sim, int AorB, seqnum_t seqnum) {
+    struct pkt packet = { 0 };
     packet.acknum = - seqnum;
-    update_pkt_checksum(&packet);
+    update_pkt_checksum(sim, &packet);
 
-    printf("[send_NAK] Enviando (acknum: %d)\n", packet.acknum);
-    tolayer3(AorB, packet);
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[send_NAK] Enviando (acknum: %lld)\n", packet.acknum);
+    sim->nnak++;
+    tolayer3(sim, AorB, packet);
 }
 
 /**
- * Desliza a o buffer, removendo pacotes que já receberam ACK
- * 
- * 1. Descobre a posição do pacote com seqnum igual ao acknum
- * 2. Identifica se mais de um pacote precisa ser removido
- * 3. Remove todos e move as posições do buffer
- * 4. Preenche as posições novas com pacotes zerados (indicando vazio)
+ * Posição do pacote de seqnum informado no buffer circular
+ */
+static struct pkt *buffer_slot(struct remetente *A, seqnum_t seqnum) {
+    return &A->pkt_buffer[seqnum % A->pkt_buffer_capacity];
+}
+
+/**
+ * Instante do envio do pacote de seqnum informado
  */
-void update_buffer_on_ack(int acknum) {
+static double *sent_at_slot(struct remetente *A, seqnum_t seqnum) {
+    return &A->sent_at[seqnum % A->pkt_buffer_capacity];
+}
 
-    if (acknum == 0) {
-        printf("[update_buffer_on_ack] Primeiro pacote falhou, pulando\n");
-        return;
+/**
+ * Timeout do remetente depois de enviar @sent pacotes de uma vez. Com --rto fixed,
+ * o RTT mais um terço dele por pacote enviado; com --rto adaptive, a estimativa
+ * atual, já que as amostras de RTT incluem o tempo na fila do meio.
+ */
+static double timer_interval(struct remetente *A, int sent) {
+    if (A->rto.kind == RTO_FIXED) {
+        return A->rto.initial + (sent * A->rto.initial / 3.0);
     }
 
-    int pkt_index = -1;
+    return rto_timeout(&A->rto);
+}
 
-    for (int i = 0; i < SENDER_BUFFER_SIZE; i++) {
-        if (A.pkt_buffer[i].packet.seqnum == acknum) {
-            pkt_index = i;
-            break;
-        }
-    }
+/**
+ * Imprime o seqnum dos pacotes nas primeiras posições do buffer, a partir da
+ * base (as posições vazias não são impressas), no nível TRACE_EVENTS
+ */
+static void print_buffer(struct simulation *sim, int positions) {
+    struct remetente *A = sender(sim);
 
-    if (pkt_index == -1) {
-        printf("[update_buffer_on_ack] O buffer não contém o pacote informado, pulando\n");
+    if (!TRACE_ON(sim, TRACE_EVENTS)) {
         return;
-    } 
+    }
 
-    printf("[update_buffer_on_ack] Buffer (current size: %d, capacity: %d, acked_pkt: %d)\n", A.pkt_buffer_current_size, SENDER_BUFFER_SIZE, A.pkt_buffer[pkt_index].packet.seqnum);
-    for (int i = 0; i < SENDER_BUFFER_SIZE; i++) {
-        printf(" %d |", A.pkt_buffer[i].packet.seqnum);
+    if (positions > A->pkt_buffer_current_size) {
+        positions = A->pkt_buffer_current_size;
     }
-    printf("\n");
 
-    for (int i = 0; i < pkt_index + 1; i++) {
-        for (int j = 0; j < SENDER_BUFFER_SIZE - 1; j++) {
-            A.pkt_buffer[j] = A.pkt_buffer[j + 1];
-        }
+    for (int i = 0; i < positions; i++) {
+        fprintf(sim->log, " %lld |", A->base + i);
+    }
+    fprintf(sim->log, "\n");
+}
 
-        struct pkt packet;
-        packet.seqnum = 0;
-        A.pkt_buffer[SENDER_BUFFER_SIZE - 1].packet = packet;
-        A.pkt_buffer[SENDER_BUFFER_SIZE - 1].sent = 0;
+/**
+ * Desliza a o buffer, removendo pacotes que já receberam ACK
+ * 
+ * 1. Verifica se o pacote com seqnum igual ao acknum está no buffer
+ * 2. Avança a base para depois dele, removendo todos os pacotes até ele
+ */
+static void update_buffer_on_ack(struct simulation *sim, seqnum_t acknum) {
+    struct remetente *A = sender(sim);
 
-        A.pkt_buffer_current_size--;
+    if (acknum == 0) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[update_buffer_on_ack] Primeiro pacote falhou, pulando\n");
+        return;
     }
 
-    printf("[update_buffer_on_ack] Buffer atualizado (current size: %d, capacity: %d)\n", A.pkt_buffer_current_size, SENDER_BUFFER_SIZE);
-    for (int i = 0; i < SENDER_BUFFER_SIZE; i++) {
-        printf(" %d |", A.pkt_buffer[i].packet.seqnum);
+    if (acknum < A->base || acknum >= A->next_seqnum) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[update_buffer_on_ack] O buffer não contém o pacote informado, pulando\n");
+        return;
+    } 
+
+    TRACE_LOG(sim, TRACE_EVENTS, "[update_buffer_on_ack] Buffer (current size: %d, capacity: %d, acked_pkt: %lld)\n", A->pkt_buffer_current_size, A->pkt_buffer_capacity, acknum);
+    print_buffer(sim, A->pkt_buffer_capacity);
+
+    A->pkt_buffer_current_size -= (int)(acknum - A->base + 1);
+    A->base = acknum + 1;
+
+    if (A->next_to_send < A->base) {
+        A->next_to_send = A->base;
     }
-    printf("\n");
+
+    TRACE_LOG(sim, TRACE_EVENTS, "[update_buffer_on_ack] Buffer atualizado (current size: %d, capacity: %d)\n", A->pkt_buffer_current_size, A->pkt_buffer_capacity);
+    print_buffer(sim, A->pkt_buffer_capacity);
 }
 
 /**
@@ -178,62 +210,61 @@ void update_buffer_on_ack(int acknum) {
  * 1. Calcula quais pacotes serão enviados, sem exceder a janela
  * 2. Envia os pacotes 1 a 1
  */
-void send_window() {
-    printf("[send_window] Buffer (current size: %d, capacity: %d)\n", A.pkt_buffer_current_size, SENDER_BUFFER_SIZE);
-    for (int i = 0; i < SENDER_BUFFER_SIZE; i++) {
-        printf(" %d |", A.pkt_buffer[i].packet.seqnum);
-    }
-    printf("\n");
+static void send_window(struct simulation *sim) {
+    struct remetente *A = sender(sim);
 
-    printf("[send_window] Window (size: %d)\n", A.pkt_window_size);
-    for (int i = 0; i < A.pkt_window_size; i++) {
-        printf(" %d |", A.pkt_buffer[i].packet.seqnum);
-    }
-    printf("\n");
+    TRACE_LOG(sim, TRACE_EVENTS, "[send_window] Buffer (current size: %d, capacity: %d)\n", A->pkt_buffer_current_size, A->pkt_buffer_capacity);
+    print_buffer(sim, A->pkt_buffer_capacity);
 
-    int number_of_packets_to_send = A.pkt_buffer_current_size > A.pkt_window_size ? A.pkt_window_size : A.pkt_buffer_current_size;
+    TRACE_LOG(sim, TRACE_EVENTS, "[send_window] Window (size: %d)\n", A->pkt_window_size);
+    print_buffer(sim, A->pkt_window_size);
+
+    int number_of_packets_to_send = A->pkt_buffer_current_size > A->pkt_window_size ? A->pkt_window_size : A->pkt_buffer_current_size;
 
     int timer_multiplier = 0;
-    for (int i = 0; i < number_of_packets_to_send; i++) {
-        printf("[send_window] Sending (pkt: %d, payload: %s)\n", A.pkt_buffer[i].packet.seqnum, A.pkt_buffer[i].packet.payload);
+    for (seqnum_t seqnum = A->base; seqnum < A->base + number_of_packets_to_send; seqnum++) {
+        struct pkt *packet = buffer_slot(A, seqnum);
+
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[send_window] Sending (pkt: %lld, payload: %s)\n", packet->seqnum, packet->payload);
+
+        if (seqnum < A->next_to_send) {
+            *sent_at_slot(A, seqnum) = -1;
+        } else {
+            *sent_at_slot(A, seqnum) = sim->time;
+        }
 
-        A.pkt_buffer[i].sent = 1;
-        tolayer3(0, A.pkt_buffer[i].packet);
+        data_sent(sim, MESSAGE(seqnum), seqnum < A->next_to_send);
+        tolayer3(sim, 0, *packet);
         timer_multiplier++;
     }
 
+    if (A->next_to_send < A->base + number_of_packets_to_send) {
+        A->next_to_send = A->base + number_of_packets_to_send;
+    }
+
     if (timer_multiplier > 0) {
-        stoptimer(0);
-        starttimer(0, A.rtt + (timer_multiplier * A.rtt / 3.0));
+        stoptimer(sim, 0);
+        starttimer(sim, 0, timer_interval(A, timer_multiplier));
     }
 }
 
 /**
  * Adiciona um novo pacote no buffer
  * 
- * 1. Adiciona o pacote na posição correta
+ * 1. Adiciona o pacote na posição do seu seqnum
  * 2. Incrementa a variável de tamanho do buffer
  */
-void add_pkt_to_buffer(struct pkt packet) {
-    printf("[add_pkt_to_buffer] Antes (buffer size: %d)\n", A.pkt_buffer_current_size);
-
-    for (int i = 0; i < SENDER_BUFFER_SIZE; i++) {
-        printf(" %d |", A.pkt_buffer[i].packet.seqnum);
-    }
-
-    printf("\n");
+static void add_pkt_to_buffer(struct simulation *sim, struct pkt packet) {
+    struct remetente *A = sender(sim);
 
-    A.pkt_buffer[A.pkt_buffer_current_size].packet = packet;
-    A.pkt_buffer[A.pkt_buffer_current_size].sent = 0;
-    A.pkt_buffer_current_size++;
+    TRACE_LOG(sim, TRACE_EVENTS, "[add_pkt_to_buffer] Antes (buffer size: %d)\n", A->pkt_buffer_current_size);
+    print_buffer(sim, A->pkt_buffer_capacity);
 
-    printf("[add_pkt_to_buffer] Depois (buffer size: %d)\n", A.pkt_buffer_current_size);
+    *buffer_slot(A, packet.seqnum) = packet;
+    A->pkt_buffer_current_size++;
 
-    for (int i = 0; i < SENDER_BUFFER_SIZE; i++) {
-        printf(" %d |", A.pkt_buffer[i].packet.seqnum);
-    }
-
-    printf("\n");
+    TRACE_LOG(sim, TRACE_EVENTS, "[add_pkt_to_buffer] Depois (buffer size: %d)\n", A->pkt_buffer_current_size);
+    print_buffer(sim, A->pkt_buffer_capacity);
 }
 
 /***********************************************/
@@ -243,27 +274,28 @@ void add_pkt_to_buffer(struct pkt packet) {
 /**
  * Inicializa remetente
  */
-void A_init() {
-    A.rtt = RTT;
-    A.pkt_window_size = SENDER_WINDOW_SIZE;
-    A.next_seqnum = 1;
-    A.pkt_buffer_current_size = 0;
-
-    for(int i = 0; i < SENDER_BUFFER_SIZE; i++) {
-        struct pkt packet;
-        packet.seqnum = 0;
-        A.pkt_buffer[i].packet = packet;
-        A.pkt_buffer[i].sent = 0;
-    }
+static void A_init(struct simulation *sim) {
+    struct remetente *A = sender(sim);
+
+    rto_init(&A->rto, sim->config.rto, sim->config.rtt > 0 ? sim->config.rtt : RTT);
+    A->pkt_window_size = sim->config.window_size > 0 ? sim->config.window_size : SENDER_WINDOW_SIZE;
+    A->pkt_buffer_capacity = sim->config.buffer_size > 0 ? sim->config.buffer_size : SENDER_BUFFER_SIZE;
+    A->pkt_buffer = malloc(A->pkt_buffer_capacity * sizeof(struct pkt));
+    A->sent_at = malloc(A->pkt_buffer_capacity * sizeof(double));
+    A->base = 1;
+    A->next_seqnum = 1;
+    A->next_to_send = 1;
+    A->pkt_buffer_current_size = 0;
 }
 
 /**
  * Chamado quando o timer do remetente é estourado
- * 
+ * (com --rto adaptive, o timeout dobra até a próxima amostra de RTT)
  */
-void A_timerinterrupt() {
-    printf("[A_timerinterrupt] Timeout, enviando janela\n");
-    send_window();
+static void A_timerinterrupt(struct simulation *sim) {
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[A_timerinterrupt] Timeout, enviando janela\n");
+    rto_backoff(&sender(sim)->rto);
+    send_window(sim);
 }
 
 /**
@@ -273,83 +305,109 @@ void A_timerinterrupt() {
  * 2. Adiciona o pacote no buffer
  * 3. Envia o pacote, se ele estiver dentro da janela
  * 4. Se o pacote for enviado, inicia o timer.
+ *
+ * Retorna 0 se a mensagem foi descartada.
  */
-void A_output(struct msg message) {
-    if (A.pkt_buffer_current_size >= SENDER_BUFFER_SIZE) {
-        printf("[A_output] Buffer cheio, descartando pacote\n");
-        return;
+static int A_output(struct simulation *sim, struct msg message) {
+    struct remetente *A = sender(sim);
+
+    if (A->pkt_buffer_current_size >= A->pkt_buffer_capacity) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[A_output] Buffer cheio, descartando pacote\n");
+        return 0;
     }
 
-    printf("[A_output] Mensagem recebida, adicionando pacote ao buffer (pkt: %d, payload: %s)\n", A.next_seqnum, message.data);
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[A_output] Mensagem recebida, adicionando pacote ao buffer (pkt: %lld, payload: %s)\n", A->next_seqnum, message.data);
 
-    struct pkt packet;
-    packet.seqnum = A.next_seqnum;
+    struct pkt packet = { 0 };
+    packet.seqnum = A->next_seqnum;
     
     for (int i = 0; i < 20; i++) {
         packet.payload[i] = message.data[i];
     }
 
-    update_pkt_checksum(&packet);
+    update_pkt_checksum(sim, &packet);
 
-    A.next_seqnum++;
+    A->next_seqnum++;
 
-    add_pkt_to_buffer(packet);
+    add_pkt_to_buffer(sim, packet);
 
-    for (int i = 0; i < A.pkt_window_size; i++) {
-        if (A.pkt_buffer[i].packet.seqnum == packet.seqnum) {
-            printf("[A_output] Sending (pkt: %d, payload: %s)\n", A.pkt_buffer[i].packet.seqnum, A.pkt_buffer[i].packet.payload);
+    if (packet.seqnum - A->base < A->pkt_window_size) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[A_output] Sending (pkt: %lld, payload: %s)\n", packet.seqnum, packet.payload);
 
-            A.pkt_buffer[i].sent = 1;
-            tolayer3(0, A.pkt_buffer[i].packet);
+        A->next_to_send = packet.seqnum + 1;
+        *sent_at_slot(A, packet.seqnum) = sim->time;
+        data_sent(sim, MESSAGE(packet.seqnum), 0);
+        tolayer3(sim, 0, packet);
 
-            starttimer(0, A.rtt);
-        }
+        starttimer(sim, 0, timer_interval(A, 0));
     }
+
+    return 1;
 }
 
 /**
  * Recebe pacote do meio
  * 
  * 1. Se o pacote está corrompido, descarta pacote
- * 2. Se o pacote é um NAK, reenvia janela a partir no pacote não recebido
+ * 2. Se o pacote é um NAK, reenvia janela a partir no pacote não recebido,
+ *    a menos que já tenha feito isso para o mesmo NAK dentro do timeout
  * 3. Envia os pacotes dentro da janela que ainda não foram enviados
  */
-void A_input(struct pkt packet) {
-    if (!is_valid_checksum(packet.checksum, &packet)) {
-        printf("[A_input] Pacote recebido corrompido, descartando\n");
+static void A_input(struct simulation *sim, struct pkt packet) {
+    struct remetente *A = sender(sim);
+
+    if (!is_valid_checksum(sim, packet.checksum, &packet)) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[A_input] Pacote recebido corrompido, descartando\n");
         return;
     }
 
     if (packet.acknum < 0) {
-        int nak_pkt = abs(packet.acknum);
+        seqnum_t nak_pkt = -packet.acknum;
 
-        printf("[A_input] NAK recebido, reenviando janela (pkt: %d)\n", nak_pkt);
+        if (nak_pkt == A->last_nak && sim->time - A->last_nak_time < timer_interval(A, 0)) {
+            TRACE_LOG(sim, TRACE_PROTOCOL, "[A_input] NAK repetido, janela já reenviada (pkt: %lld)\n", nak_pkt);
+            return;
+        }
 
-        update_buffer_on_ack(nak_pkt - 1);
-        send_window();
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[A_input] NAK recebido, reenviando janela (pkt: %lld)\n", nak_pkt);
+
+        A->last_nak = nak_pkt;
+        A->last_nak_time = sim->time;
+
+        update_buffer_on_ack(sim, nak_pkt - 1);
+        send_window(sim);
 
         return;
     }
 
-    printf("[A_input] ACK recebido, deslizando janela (pkt: %d)\n", packet.acknum);
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[A_input] ACK recebido, deslizando janela (pkt: %lld)\n", packet.acknum);
 
-    update_buffer_on_ack(packet.acknum);
+    if (packet.acknum >= A->base && packet.acknum < A->next_to_send && *sent_at_slot(A, packet.acknum) >= 0) {
+        rto_sample(&A->rto, sim->time - *sent_at_slot(A, packet.acknum));
+    }
+
+    update_buffer_on_ack(sim, packet.acknum);
+
+    seqnum_t window_end = A->base + A->pkt_window_size < A->next_seqnum ? A->base + A->pkt_window_size : A->next_seqnum;
 
     int timer_multiplier = 0;
-    for (int i = 0; i < A.pkt_window_size; i++) {
-        if (A.pkt_buffer[i].packet.seqnum != 0 && A.pkt_buffer[i].sent == 0) {
-            printf("[A_input] Sending (pkt: %d, payload: %s)\n", A.pkt_buffer[i].packet.seqnum, A.pkt_buffer[i].packet.payload);
+    for (; A->next_to_send < window_end; A->next_to_send++) {
+        struct pkt *unsent = buffer_slot(A, A->next_to_send);
 
-            A.pkt_buffer[i].sent = 1;
-            tolayer3(0, A.pkt_buffer[i].packet);
-            timer_multiplier++;
-        }
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[A_input] Sending (pkt: %lld, payload: %s)\n", unsent->seqnum, unsent->payload);
+
+        *sent_at_slot(A, A->next_to_send) = sim->time;
+        data_sent(sim, MESSAGE(A->next_to_send), 0);
+        tolayer3(sim, 0, *unsent);
+        timer_multiplier++;
     }
 
-    stoptimer(0);
+    stoptimer(sim, 0);
 
-    if (timer_multiplier > 0) {
-        starttimer(0, A.rtt + (timer_multiplier * A.rtt / 3.0));
+    /* keep timing the packets still unacked: with one NAK per gap, the timer */
+    /* is the only recovery when the NAK or the retransmission is lost */
+    if (timer_multiplier > 0 || A->base < A->next_to_send) {
+        starttimer(sim, 0, timer_interval(A, timer_multiplier));
     }
 }
 
@@ -360,512 +418,117 @@ void A_input(struct pkt packet) {
 /**
  * Inicializa receptor
  */
-void B_init() {
-    B.expected_seqnum = 1;
-}
+static void B_init(struct simulation *sim) {
+    struct receptor *B = receiver(sim);
 
-/**
- * Chamado quando o timer do receptor é estourado
- * (Não utilizado)
- */
-void B_timerinterrupt() {
-    printf("[B_timerinterrupt] Não implementado\n");
+    B->expected_seqnum = 1;
+    B->nak_seqnum = 0;
+    B->nak_timeout = sim->config.rtt > 0 ? sim->config.rtt : RTT;
 }
 
 /**
- * Recebe mensagem da camada aplicação
- * (Não utilizado)
+ * Chamado quando o timer do NAK é estourado: o pacote pedido não chegou,
+ * então o próximo pacote fora de ordem pode pedir ele de novo
  */
-void B_output(struct msg message) {
-    printf("[B_output] Não implementado\n");
+static void B_timerinterrupt(struct simulation *sim) {
+    struct receptor *B = receiver(sim);
+
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[B_timerinterrupt] Timeout do NAK (pkt: %lld)\n", B->nak_seqnum);
+    B->nak_seqnum = 0;
 }
 
 /**
- * Recebe pacote do meio
- * 
- * 1. Se o pacote está corrompido, manda NAK
- * 2. Se o pacote não é o esperado, manda NAK
- * 3. Manda mensagem para a camada de aplicação
- * 4. Manda ACK para o meio
+ * Pede o pacote esperado com um NAK, se ainda não pediu desde o último
+ * timeout do NAK
  */
-void B_input(struct pkt packet) {
-    if(!is_valid_checksum(packet.checksum, &packet)) {
-        printf("[B_input] Pacote recebido corrompido, mandando NAK (expected_seqnum: %d)\n", B.expected_seqnum);
-        send_NAK(1, B.expected_seqnum);
-        return;
-    }
+static void request_expected(struct simulation *sim) {
+    struct receptor *B = receiver(sim);
 
-    if (packet.seqnum != B.expected_seqnum) {
-        printf("[B_input] Pacote recebido fora de ordem, mandando NAK (pkt: %d, expected_seqnum: %d)\n", packet.seqnum, B.expected_seqnum);
-        send_NAK(1, B.expected_seqnum);
+    if (B->nak_seqnum == B->expected_seqnum) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] NAK já enviado, descartando (expected_seqnum: %lld)\n", B->expected_seqnum);
         return;
     }
 
-    printf("[B_input] Pacote recebido com sucesso (pkt: %d, payload: %s)\n", packet.seqnum, packet.payload);
-
-    tolayer5(1, packet.payload);
-    send_ACK(1, packet.seqnum);
-    B.expected_seqnum++;
+    send_NAK(sim, 1, B->expected_seqnum);
 
-    printf("[B_input] Aguardando próximo pacote (pkt: %d)\n", B.expected_seqnum);
+    /* no NAK timer is running: nak_seqnum is only ever 0 or expected_seqnum, */
+    /* and it is cleared whenever expected_seqnum advances */
+    B->nak_seqnum = B->expected_seqnum;
+    starttimer(sim, 1, B->nak_timeout);
 }
 
-/***********************************************/
-/*     NETWORK EMULATION CODE STARTS BELOW      */
-/***********************************************/
-
-struct event {
-    float evtime;           /* event time */
-    int evtype;             /* event type code */
-    int eventity;           /* entity where event occurs */
-    struct pkt *pktptr;     /* ptr to packet (if any) assoc w/ this event */
-    struct event *prev;
-    struct event *next;
-};
-
-struct event *evlist = NULL;   /* the event list */
-
-/* possible events: */
-#define TIMER_INTERRUPT    0
-#define FROM_LAYER5        1
-#define FROM_LAYER3        2
-
-#define OFF                0
-#define ON                 1
-#define A                  0
-#define B                  1
-
-int TRACE = 1;                  /* for my debugging */
-int nsim = 0;                   /* number of messages from 5 to 4 so far */
-int nsimmax = 0;                /* number of msgs to generate, then stop */
-float time = (float)0.000;
-float lossprob;                 /* probability that a packet is dropped  */
-float corruptprob;              /* probability that one bit is packet is flipped */
-float lambda;                   /* arrival rate of messages from layer 5 */
-int ntolayer3;                  /* number sent into layer 3 */
-int nlost;                      /* number lost in media */
-int ncorrupt;                   /* number corrupted by media*/
-
-void init();
-void generate_next_arrival();
-void insertevent(struct event *p);
-
-int main() {
-    struct event *eventptr;
-    struct msg  msg2give;
-    struct pkt  pkt2give;
-
-    int i,j;
-    char c;
-
-    init();
-    A_init();
-    B_init();
-
-    while (1) {
-        /* get next event to simulate */
-        eventptr = evlist;
-
-        if (eventptr == NULL) {
-            goto terminate;
-        }
-        
-        /* remove this event from event list */
-        evlist = evlist->next;  
-
-        if (evlist != NULL) {
-            evlist->prev = NULL;
-        }
-           
-        if (TRACE >= 2) {
-            printf("\nEVENT time: %f,", eventptr->evtime);
-            printf("  type: %d", eventptr->evtype);
-
-            if (eventptr->evtype == 0) {
-                printf(", timerinterrupt  ");
-            } else if (eventptr->evtype == 1) {
-                printf(", fromlayer5 ");
-            } else {
-                printf(", fromlayer3 ");
-            }
-	     
-            printf(" entity: %d\n", eventptr->eventity);
-        }
-
-        /* update time to next event time */
-        time = eventptr->evtime;
-	  
-        if (eventptr->evtype == FROM_LAYER5 && nsim < nsimmax) {
-            /* set up future arrival */
-            if (nsim + 1 < nsimmax) {
-                generate_next_arrival();
-            }
-
-            /* fill in msg to give with string of same letter */
-            j = nsim % 26;
-            for (i = 0; i < 20; i++) {
-                msg2give.data[i] = 97 + j;
-            }
-            msg2give.data[19] = 0;
-               
-            if (TRACE > 2) {
-                printf("          MAINLOOP: data given to student: ");
-
-                for (i = 0; i < 20; i++) {
-                    printf("%c", msg2give.data[i]);
-                }
-                  
-               printf("\n");
-	        }
-
-            nsim++;
-
-            if (eventptr->eventity == A) {
-                A_output(msg2give);
-            } else {
-                B_output(msg2give);
-            }
-        } else if (eventptr->evtype == FROM_LAYER3) {
-            pkt2give.seqnum = eventptr->pktptr->seqnum;
-            pkt2give.acknum = eventptr->pktptr->acknum;
-            pkt2give.checksum = eventptr->pktptr->checksum;
-
-            for (i = 0; i < 20; i++) {
-                pkt2give.payload[i] = eventptr->pktptr->payload[i];
-            }
-            
-            /* deliver packet by calling */
-            if (eventptr->eventity == A) {
-                A_input(pkt2give);
-            } else {
-                B_input(pkt2give);
-            }
-            
-            /* free the memory for packet */
-            free(eventptr->pktptr);
-        } else if (eventptr->evtype == TIMER_INTERRUPT) {
-            if (eventptr->eventity == A) {
-                A_timerinterrupt();
-            } else {
-                B_timerinterrupt();
-            }
-        } else {
-	        printf("INTERNAL PANIC: unknown event type \n");
-        }
-
-        free(eventptr);
-    }
-
-    terminate:
-        printf("\nSimulator terminated at time %f after sending %d msgs from layer5\n", time, nsim);
-}
-
-/***********************************************/
-/*           INITIALIZE THE SIMULATOR          */
-/***********************************************/
-
-void init() {
-    int i;
-    float sum, avg;
-    float jimsrand();
-
-    printf("-----  Stop and Wait Network Simulator Version 1.1 -------- \n\n");
-    printf("Enter the number of messages to simulate: ");
-    scanf("%d", &nsimmax);
-    printf("Enter  packet loss probability [enter 0.0 for no loss]:");
-    scanf("%f", &lossprob);
-    printf("Enter packet corruption probability [0.0 for no corruption]:");
-    scanf("%f", &corruptprob);
-    printf("Enter average time between messages from sender's layer5 [ > 0.0]:");
-    scanf("%f", &lambda);
-    printf("Enter TRACE:");
-    scanf("%d", &TRACE);
-
-    /* init random number generator */
-    srand(9999);
-
-    /* test random number generator for students */
-    sum = (float)0.0;   
-
-    for (i = 0; i < 1000; i++) {
-        /* jimsrand() should be uniform in [0,1] */
-        sum = sum + jimsrand();
-    }
-      
-    avg = sum / (float)1000.0;
-
-    if (avg < 0.25 || avg > 0.75) {
-        printf("It is likely that random number generation on your machine\n" );
-        printf("is different from what this emulator expects.  Please take\n");
-        printf("a look at the routine jimsrand() in the emulator code. Sorry. \n");
-        exit(0);
-    }
-
-    ntolayer3 = 0;
-    nlost = 0;
-    ncorrupt = 0;
-
-    /* initialize time to 0.0 */
-    time = (float)0.0;
-
-    /* initialize event list */
-    generate_next_arrival();
-}
-
-/***********************************************/
-/*           RANDOM GENERATOR ROUTINE          */
-/***********************************************/
-
-float jimsrand() {
-    /* largest int  - MACHINE DEPENDENT!!!!!!!!   */
-    double mmm = RAND_MAX;
-
-    /* individual students may need to change mmm */
-    float x;
-
-    /* x should be uniform in [0,1] */
-    x = (float)(rand() / mmm);
-
-    return(x);
-}
-
-/***********************************************/
-/*           EVENT HANDLINE ROUTINES           */
-/***********************************************/
-
-void generate_next_arrival() {
-    double x, log(), ceil();
-    struct event *evptr;
-
-    if (TRACE > 2) {
-        printf("          GENERATE NEXT ARRIVAL: creating new arrival\n");
-    }
-
-    /* x is uniform on [0,2*lambda] */
-    /* having mean of lambda        */
-    x = lambda * jimsrand() * 2;
-
-    evptr = (struct event *)malloc(sizeof(struct event));
-    evptr->evtime = (float)(time + x);
-    evptr->evtype = FROM_LAYER5;
-
-    if (BIDIRECTIONAL && (jimsrand() > 0.5)) {
-        evptr->eventity = B;
-    } else {
-        evptr->eventity = A;
-    }
-
-    insertevent(evptr);
-}
-
-void insertevent(struct event *p) {
-    struct event *q, *qold;
-
-    if (TRACE > 2) {
-        printf("            INSERTEVENT: time is %lf\n", time);
-        printf("            INSERTEVENT: future time will be %lf\n", p->evtime);
-    }
-
-    /* q points to header of list in which p struct inserted */
-    q = evlist;
-
-    /* list is empty */
-    if (q == NULL) {
-        evlist = p;
-        p->next = NULL;
-        p->prev = NULL;
-    } else {
-        for (qold = q; q != NULL && p->evtime > q->evtime; q = q->next) {
-            qold=q;
-        }
-
-        if (q == NULL) {            /* end of list */
-            qold->next = p;
-            p->prev = qold;
-            p->next = NULL;
-        } else if (q == evlist) {   /* front of list */
-            p->next = evlist;
-            p->prev = NULL;
-            p->next->prev = p;
-            evlist = p;
-        } else {                    /* middle of list */
-            p->next = q;
-            p->prev = q->prev;
-            q->prev->next = p;
-            q->prev = p;
-        }
-    }
-}
-
-void printevlist() {
-    struct event *q;
-
-    printf("--------------\nEvent List Follows:\n");
-
-    for(q = evlist; q != NULL; q = q->next) {
-        printf("Event time: %f, type: %d entity: %d\n", q->evtime, q->evtype, q->eventity);
-    }
-
-    printf("--------------\n");
-}
-
-/***********************************************/
-/*          STUDENT-CALLABLE ROUTINES          */
-/***********************************************/
-
-void stoptimer(int AorB) {
-    struct event *q;
-
-    if (TRACE > 2) {
-        printf("          STOP TIMER: stopping timer at %f\n", time);
-    }
-    
-    /* for (q = evlist; q != NULL && q->next != NULL; q = q->next)  */
-    for (q = evlist; q != NULL; q = q->next) {
-        if ((q->evtype == TIMER_INTERRUPT && q->eventity == AorB)) {
-            /* remove this event */
-            if (q->next == NULL && q->prev == NULL) {   /* remove first and only event on list */
-                evlist = NULL;
-            } else if (q->next == NULL) {               /* end of list - there is one in front */
-                q->prev->next = NULL;
-            } else if (q == evlist) {                   /* front of list - there must be event after */
-                q->next->prev = NULL;
-                evlist = q->next;
-            } else {                                    /* middle of list */
-                q->next->prev = q->prev;
-                q->prev->next = q->next;
-            }
-
-            free(q);
-            return;
-        }
-    }
-    
-    printf("Warning: unable to cancel your timer. It wasn't running.\n");
-}
-
-void starttimer(int AorB, float increment) {
-    struct event *q;
-    struct event *evptr;
-
-    if (TRACE > 2) {
-        printf("          START TIMER: starting timer at %f\n",time);
-    }
-
-    /* be nice: check to see if timer is already started, if so, then warn */
-    /* for (q = evlist; q != NULL && q->next != NULL; q = q->next) */
-    for (q = evlist; q != NULL; q = q->next) {
-        if ((q->evtype == TIMER_INTERRUPT && q->eventity == AorB)) {
-            printf("Warning: attempt to start a timer that is already started\n");
-            return;
-        }
-    }
-
-    /* create future event for when timer goes off */
-    evptr = (struct event *)malloc(sizeof(struct event));
-    evptr->evtime = (float)(time + increment);
-    evptr->evtype = TIMER_INTERRUPT;
-    evptr->eventity = AorB;
-
-    insertevent(evptr);
+/**
+ * Recebe mensagem da camada aplicação
+ * (Não utilizado)
+ */
+static int B_output(struct simulation *sim, struct msg message) {
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[B_output] Não implementado\n");
+    return 0;
 }
 
-void tolayer3(int AorB, struct pkt packet) {
-    struct pkt *mypktptr;
-    struct event *evptr, *q;
-    float lastime, x, jimsrand();
-    int i;
-
-    ntolayer3++;
-
-    /* simulate losses: */
-    if (jimsrand() < lossprob) {
-        nlost++;
+/**
+ * Recebe pacote do meio
+ * 
+ * 1. Se o pacote está corrompido, manda NAK (uma vez por lacuna)
+ * 2. Se o pacote já foi entregue, repete o ACK do último entregue
+ * 3. Se o pacote não é o esperado, manda NAK (uma vez por lacuna)
+ * 4. Manda mensagem para a camada de aplicação
+ * 5. Manda ACK para o meio
+ */
+static void B_input(struct simulation *sim, struct pkt packet) {
+    struct receptor *B = receiver(sim);
 
-        if (TRACE > 0) {
-            printf("          TOLAYER3: packet being lost\n");
-        }
-    
+    if(!is_valid_checksum(sim, packet.checksum, &packet)) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] Pacote recebido corrompido, mandando NAK (expected_seqnum: %lld)\n", B->expected_seqnum);
+        request_expected(sim);
         return;
     }
 
-    /* make a copy of the packet student just gave me since he/she may decide */
-    /* to do something with the packet after we return back to him/her */
-    mypktptr = (struct pkt *)malloc(sizeof(struct pkt));
-    mypktptr->seqnum = packet.seqnum;
-    mypktptr->acknum = packet.acknum;
-    mypktptr->checksum = packet.checksum;
-
-    for (i = 0; i < 20; i++) {
-        mypktptr->payload[i] = packet.payload[i];
+    if (packet.seqnum < B->expected_seqnum) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] Pacote repetido, reenviando ACK (pkt: %lld, expected_seqnum: %lld)\n", packet.seqnum, B->expected_seqnum);
+        send_ACK(sim, 1, B->expected_seqnum - 1);
+        return;
     }
 
-    if (TRACE > 2) {
-        printf("          TOLAYER3: seq: %d, ack %d, check: %d ", mypktptr->seqnum, mypktptr->acknum, mypktptr->checksum);
-
-        for (i = 0; i < 20; i++) {
-            printf("%c", mypktptr->payload[i]);
-        }
-
-        printf("\n");
+    if (packet.seqnum != B->expected_seqnum) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] Pacote recebido fora de ordem, mandando NAK (pkt: %lld, expected_seqnum: %lld)\n", packet.seqnum, B->expected_seqnum);
+        request_expected(sim);
+        return;
     }
 
-    /* create future event for arrival of packet at the other side */
-    evptr = (struct event *)malloc(sizeof(struct event));
-    evptr->evtype = FROM_LAYER3;    /* packet will pop out from layer3 */
-    evptr->eventity = (AorB + 1) % 2;   /* event occurs at other entity */
-    evptr->pktptr = mypktptr;   /* save ptr to my copy of packet */
-    
-    /* finally, compute the arrival time of packet at the other end.
-    medium can not reorder, so make sure packet arrives between 1 and 10
-    time units after the latest arrival time of packets
-    currently in the medium on their way to the destination */
-
-    lastime = time;
-
-    /* for (q = evlist; q != NULL && q->next != NULL; q = q->next) */
-    for (q = evlist; q != NULL; q = q->next) {
-        if ((q->evtype == FROM_LAYER3 && q->eventity == evptr->eventity)) {
-            lastime = q->evtime;
-        }
+    /* the gap (if any) is closed */
+    if (B->nak_seqnum != 0) {
+        stoptimer(sim, 1);
+        B->nak_seqnum = 0;
     }
 
-    evptr->evtime = lastime + 1 + 9 * jimsrand();
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] Pacote recebido com sucesso (pkt: %lld, payload: %s)\n", packet.seqnum, packet.payload);
 
-    /* simulate corruption: */
-    if (jimsrand() < corruptprob) {
-        ncorrupt++;
+    tolayer5(sim, 1, packet.payload);
+    send_ACK(sim, 1, packet.seqnum);
+    B->expected_seqnum++;
 
-        if ((x = jimsrand()) < .75) {
-            mypktptr->payload[0] = 'Z'; /* corrupt payload */
-        } else if (x < .875) {
-            mypktptr->seqnum = 999999;
-        } else {
-            mypktptr->acknum = 999999;
-        }
-
-        if (TRACE > 0) {
-            printf("          TOLAYER3: packet being corrupted\n");
-        }
-    }
-
-    if (TRACE > 2) {
-        printf("          TOLAYER3: scheduling arrival on other side\n");
-    }
-     
-    insertevent(evptr);
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] Aguardando próximo pacote (pkt: %lld)\n", B->expected_seqnum);
 }
 
-void tolayer5(int AorB, char datasent[20]) {
-    int i;
-
-    if (TRACE > 2) {
-        printf("          TOLAYER5: data received: ");
-
-        for (i = 0; i < 20; i++) {
-            printf("%c", datasent[i]);
-        }
+/**
+ * Libera os buffers alocados em A_init
+ */
+static void destroy(struct simulation *sim) {
+    free(sender(sim)->pkt_buffer);
+    free(sender(sim)->sent_at);
+}
 
-        printf("\n");
-    }
-}
\ No newline at end of file
+const struct protocol go_back_n_protocol = {
+    .name = "gbn",
+    .state_size = sizeof(struct go_back_n),
+    .A_init = A_init,
+    .A_output = A_output,
+    .A_input = A_input,
+    .A_timerinterrupt = A_timerinterrupt,
+    .B_init = B_init,
+    .B_output = B_output,
+    .B_input = B_input,
+    .B_timerinterrupt = B_timerinterrupt,
+    .destroy = destroy,
+};
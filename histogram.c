@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "histogram.h"
+
+/***********************************************/
+/*          LOG-BUCKETED HISTOGRAM             */
+/***********************************************/
+
+/* values (in units) from here on are counted in the last bucket */
+#define HIST_MAX_UNITS      9.2e18
+
+void hist_init(struct histogram *h, double unit) {
+    h->unit = unit;
+    h->counts = calloc(HIST_BUCKETS, sizeof(uint64_t));
+    h->count = 0;
+    h->sum = 0.0;
+    h->min = 0.0;
+    h->max = 0.0;
+}
+
+void hist_destroy(struct histogram *h) {
+    free(h->counts);
+    h->counts = NULL;
+}
+
+/**
+ * Balde de um valor de @x unidades: abaixo de HIST_SUB_COUNT, um balde por
+ * unidade; acima, os HIST_SUB_BITS + 1 bits mais altos de @x
+ */
+static int bucket_index(uint64_t x) {
+    int shift;
+
+    if (x < HIST_SUB_COUNT) {
+        return (int)x;
+    }
+
+    shift = 63 - __builtin_clzll(x) - HIST_SUB_BITS;
+
+    return (shift << HIST_SUB_BITS) + (int)(x >> shift);
+}
+
+/**
+ * Valor (em unidades) que representa o balde @index: o meio do intervalo
+ * de valores que caem nele
+ */
+static double bucket_value(int index) {
+    int shift;
+    uint64_t sub;
+
+    if (index < 2 * HIST_SUB_COUNT) {
+        return index;
+    }
+
+    shift = (index >> HIST_SUB_BITS) - 1;
+    sub = (uint64_t)(index & (HIST_SUB_COUNT - 1)) + HIST_SUB_COUNT;
+
+    return (double)(sub << shift) + ((double)((uint64_t)1 << shift) - 1) / 2;
+}
+
+void hist_add(struct histogram *h, double value) {
+    double units = value > 0 ? value / h->unit : 0.0;
+    uint64_t x = units < HIST_MAX_UNITS ? (uint64_t)units : (uint64_t)HIST_MAX_UNITS;
+
+    h->counts[bucket_index(x)]++;
+
+    if (h->count == 0 || value < h->min) {
+        h->min = value;
+    }
+
+    if (h->count == 0 || value > h->max) {
+        h->max = value;
+    }
+
+    h->count++;
+    h->sum += value;
+}
+
+double hist_mean(const struct histogram *h) {
+    return h->count > 0 ? h->sum / h->count : 0.0;
+}
+
+/**
+ * Menor valor que pelo menos uma fração @p (entre 0 e 1) das observações não
+ * excede, aproximado pelo meio do seu balde; 0 se não houver observações
+ */
+double hist_percentile(const struct histogram *h, double p) {
+    long long rank = (long long)(p * h->count);
+    long long seen = 0;
+
+    if (h->count == 0) {
+        return 0.0;
+    }
+
+    if (rank < p * h->count || rank < 1) {
+        rank++;
+    }
+
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+
+        if (seen >= rank) {
+            double value = bucket_value(i) * h->unit;
+
+            return value < h->min ? h->min : value > h->max ? h->max : value;
+        }
+    }
+
+    return h->max;
+}
@@ -0,0 +1,38 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+
+/* buckets as in HdrHistogram: each power of two split in HIST_SUB_COUNT */
+/* linear sub-buckets, so every bucket is narrower than 1/HIST_SUB_COUNT */
+/* of its values and the whole 64-bit range fits in HIST_BUCKETS counters */
+#define HIST_SUB_BITS       7
+#define HIST_SUB_COUNT      (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS        ((64 - HIST_SUB_BITS + 1) * HIST_SUB_COUNT)
+
+/**
+ * Histograma com baldes logarítmicos: ocupa o mesmo espaço qualquer que seja
+ * o número de observações, e os percentis saem com erro relativo menor que
+ * 1/HIST_SUB_COUNT (os valores menores que HIST_SUB_COUNT unidades são exatos)
+ *
+ * @unit: menor diferença entre valores que o histograma distingue
+ * @counts: observações em cada balde (HIST_BUCKETS)
+ * @count: número de observações
+ * @sum, @min, @max: soma, menor e maior valor observado (exatos)
+ */
+struct histogram {
+    double unit;
+    uint64_t *counts;
+    long long count;
+    double sum;
+    double min;
+    double max;
+};
+
+void hist_init(struct histogram *h, double unit);
+void hist_destroy(struct histogram *h);
+void hist_add(struct histogram *h, double value);
+double hist_mean(const struct histogram *h);
+double hist_percentile(const struct histogram *h, double p);
+
+#endif
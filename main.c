@@ -0,0 +1,116 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "emulator.h"
+#include "replication.h"
+#include "simulation.h"
+
+/***********************************************/
+/*          SINGLE SIMULATION PROGRAM          */
+/***********************************************/
+
+/* protocol the program is built with (make passes -DPROTOCOL=...) */
+#ifndef PROTOCOL
+#define PROTOCOL           go_back_n_protocol
+#endif
+
+/**
+ * Grava o resumo das execuções no arquivo de --summary, se foi pedido
+ */
+static int write_summary(const struct sim_config *config, const struct run_result *results, int nresults) {
+    FILE *out;
+
+    if (config->summary == NULL) {
+        return 0;
+    }
+
+    if ((out = fopen(config->summary, "w")) == NULL) {
+        fprintf(stderr, "unable to open summary file %s\n", config->summary);
+        return 1;
+    }
+
+    run_summary(out, config, &PROTOCOL, results, nresults);
+    fclose(out);
+
+    return 0;
+}
+
+/**
+ * Executa as replicações pedidas com --replications em paralelo e imprime
+ * o resumo em @log (a saída de cada simulação é descartada)
+ */
+static int run_replications(const struct sim_config *config, FILE *log) {
+    struct run_result *results = calloc(config->replications, sizeof(struct run_result));
+    int nthreads = config->threads > 0 ? config->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int status;
+
+    if (config->bintrace != NULL) {
+        fprintf(stderr, "a binary trace can not be written with replications\n");
+        free(results);
+        return 1;
+    }
+
+    if (!replicate(config, &PROTOCOL, config->replications, nthreads, results)) {
+        fprintf(stderr, "unable to run the replications\n");
+        free(results);
+        return 1;
+    }
+
+    replication_report(log, config, &PROTOCOL, results, config->replications);
+    status = write_summary(config, results, config->replications);
+    free(results);
+
+    return status;
+}
+
+/**
+ * Executa uma simulação, com a saída em @log
+ */
+static int run_single(const struct sim_config *config, FILE *log) {
+    struct simulation sim;
+    struct run_result result;
+
+    if (!sim_init(&sim, config, &PROTOCOL, log)) {
+        return 1;
+    }
+
+    sim_run(&sim);
+    run_collect(&sim, &result);
+    sim_destroy(&sim);
+
+    return write_summary(config, &result, 1);
+}
+
+int main(int argc, char **argv) {
+    struct sim_config config;
+    FILE *log = stdout;
+    int status;
+
+    config_defaults(&config);
+    config_parse_args(&config, argc, argv);
+
+    if (config.output != NULL && (log = fopen(config.output, "w")) == NULL) {
+        fprintf(stderr, "unable to open output file %s\n", config.output);
+        config_free(&config);
+        return 1;
+    }
+
+    /* parameters not given as options are asked as before */
+    config_prompt(&config);
+
+    if (config.replications > 1) {
+        status = run_replications(&config, log);
+    } else {
+        status = run_single(&config, log);
+    }
+
+    if (log != stdout) {
+        fclose(log);
+    }
+
+    config_free(&config);
+
+    return status;
+}
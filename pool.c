@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#include "pool.h"
+
+/***********************************************/
+/*           FIXED-SIZE OBJECT POOL            */
+/***********************************************/
+
+#define POOL_ALIGN          _Alignof(max_align_t)
+#define POOL_MAX_SLAB_OBJS  65536
+
+/**
+ * Cabeçalho de cada slab, seguido pelos objetos
+ */
+struct pool_slab {
+    struct pool_slab *next;
+    max_align_t objects[];
+};
+
+void pool_init(struct pool *p, size_t objsize, size_t slab_objs) {
+    if (objsize < sizeof(void *)) {
+        objsize = sizeof(void *);
+    }
+
+    p->objsize = (objsize + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN;
+    p->slab_objs = slab_objs > 0 ? slab_objs : 1;
+    p->free_list = NULL;
+    p->slabs = NULL;
+    p->fresh = NULL;
+    p->fresh_left = 0;
+
+    p->allocs = 0;
+    p->hits = 0;
+    p->growths = 0;
+    p->in_use = 0;
+    p->peak = 0;
+    p->capacity = 0;
+}
+
+/**
+ * Devolve todos os slabs ao sistema (os objetos em uso deixam de ser válidos)
+ */
+void pool_destroy(struct pool *p) {
+    struct pool_slab *slab = p->slabs;
+
+    while (slab != NULL) {
+        struct pool_slab *next = slab->next;
+        free(slab);
+        slab = next;
+    }
+
+    p->slabs = NULL;
+    p->free_list = NULL;
+    p->fresh = NULL;
+    p->fresh_left = 0;
+}
+
+/**
+ * Pede um novo slab ao sistema, dobrando o tamanho do anterior
+ */
+static void pool_grow(struct pool *p) {
+    struct pool_slab *slab = malloc(sizeof(struct pool_slab) + p->slab_objs * p->objsize);
+
+    if (slab == NULL) {
+        printf("INTERNAL PANIC: out of memory growing pool\n");
+        exit(1);
+    }
+
+    slab->next = p->slabs;
+    p->slabs = slab;
+    p->fresh = (char *)slab->objects;
+    p->fresh_left = p->slab_objs;
+    p->capacity += p->slab_objs;
+    p->growths++;
+
+    if (p->slab_objs < POOL_MAX_SLAB_OBJS) {
+        p->slab_objs *= 2;
+    }
+}
+
+void *pool_alloc(struct pool *p) {
+    void *obj;
+
+    p->allocs++;
+
+    if (p->free_list != NULL) {
+        obj = p->free_list;
+        p->free_list = *(void **)obj;
+        p->hits++;
+    } else {
+        if (p->fresh_left == 0) {
+            pool_grow(p);
+        }
+
+        obj = p->fresh;
+        p->fresh += p->objsize;
+        p->fresh_left--;
+    }
+
+    if (++p->in_use > p->peak) {
+        p->peak = p->in_use;
+    }
+
+    return obj;
+}
+
+void pool_free(struct pool *p, void *obj) {
+    *(void **)obj = p->free_list;
+    p->free_list = obj;
+    p->in_use--;
+}
+
+void pool_print_stats(FILE *out, const char *name, const struct pool *p) {
+    fprintf(out, "Pool %s: %lu allocs, %lu hits (%.1f%%), %lu slabs, peak %lu in use, capacity %lu\n",
+        name, p->allocs, p->hits, p->allocs ? 100.0 * p->hits / p->allocs : 0.0,
+        p->growths, p->peak, p->capacity);
+}
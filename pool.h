@@ -0,0 +1,45 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/**
+ * Alocador de objetos de tamanho fixo: os objetos liberados vão para uma
+ * lista livre e são reaproveitados; quando ela está vazia os objetos saem
+ * de slabs, que crescem em tamanho a cada nova alocação ao sistema
+ *
+ * @objsize: tamanho de cada objeto (arredondado para o alinhamento máximo)
+ * @slab_objs: número de objetos do próximo slab
+ * @free_list: objetos liberados, encadeados pela primeira palavra
+ * @slabs: slabs alocados, para liberar no final
+ * @fresh, @fresh_left: parte ainda não usada do último slab
+ * @allocs: total de alocações
+ * @hits: alocações atendidas pela lista livre
+ * @growths: número de slabs pedidos ao sistema
+ * @in_use, @peak: objetos em uso agora e no máximo
+ * @capacity: objetos que cabem em todos os slabs
+ */
+struct pool {
+    size_t objsize;
+    size_t slab_objs;
+    void *free_list;
+    void *slabs;
+    char *fresh;
+    size_t fresh_left;
+
+    unsigned long allocs;
+    unsigned long hits;
+    unsigned long growths;
+    unsigned long in_use;
+    unsigned long peak;
+    unsigned long capacity;
+};
+
+void pool_init(struct pool *p, size_t objsize, size_t slab_objs);
+void pool_destroy(struct pool *p);
+void *pool_alloc(struct pool *p);
+void pool_free(struct pool *p, void *obj);
+void pool_print_stats(FILE *out, const char *name, const struct pool *p);
+
+#endif
@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "config.h"
+#include "emulator.h"
+#include "replication.h"
+#include "simulation.h"
+#include "stats.h"
+
+/***********************************************/
+/*          INDEPENDENT REPLICATIONS           */
+/***********************************************/
+
+/**
+ * Estado compartilhado pelas threads de run_pool(): a próxima execução a
+ * fazer e se alguma thread não pôde abrir o seu log
+ */
+struct run_pool {
+    run_fn run;
+    void *arg;
+    long nruns;
+    long next;
+    int failed;
+    pthread_mutex_t lock;
+};
+
+/**
+ * Argumentos de replicate_one()
+ */
+struct replication_args {
+    const struct sim_config *config;
+    const struct protocol *protocol;
+    struct run_result *results;
+};
+
+/**
+ * Semente de uma replicação. A replicação 0 usa a semente do ponto, então
+ * ela reproduz uma execução isolada do simulador com os mesmos parâmetros;
+ * as outras são derivadas dela (splitmix64). A semente não depende do ponto:
+ * pontos diferentes usam os mesmos números aleatórios em cada replicação.
+ */
+unsigned int replication_seed(unsigned int seed, long replication) {
+    uint64_t z = ((uint64_t)seed << 32 | (uint32_t)replication) + 0x9e3779b97f4a7c15ULL;
+
+    if (replication == 0) {
+        return seed;
+    }
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    z = z ^ (z >> 31);
+
+    return (unsigned int)(z >> 32);
+}
+
+/**
+ * Executa uma simulação completa e guarda os contadores em @result
+ */
+void run_simulation(const struct sim_config *config, const struct protocol *protocol,
+                    FILE *log, struct run_result *result) {
+    struct simulation sim;
+
+    memset(result, 0, sizeof(*result));
+    result->seed = config->seed;
+
+    if (!sim_init(&sim, config, protocol, log)) {
+        result->stopped = 1;
+        return;
+    }
+
+    sim_run(&sim);
+    run_collect(&sim, result);
+    sim_destroy(&sim);
+}
+
+/**
+ * Copia os contadores de uma simulação já executada para @result
+ */
+void run_collect(const struct simulation *sim, struct run_result *result) {
+    result->seed = sim->config.seed;
+    result->time = sim->time;
+    result->nsim = sim->nsim;
+    result->naccepted = sim->naccepted;
+    result->ntolayer5 = sim->ntolayer5;
+    result->ntolayer3 = sim->ntolayer3;
+    result->nlost = sim->nlost;
+    result->ncorrupt = sim->ncorrupt;
+    result->nundetected = sim->nundetected;
+    result->nretransmit = sim->nretransmit;
+    result->ndata = sim->ndata;
+    result->nnak = sim->nnak;
+    result->ntimeout = sim->ntimeout;
+    result->nevents = sim->nevents;
+    result->wall_time = sim->wall_time;
+    result->latency = hist_mean(&sim->latency);
+    result->latency_p50 = hist_percentile(&sim->latency, 0.5);
+    result->latency_p99 = hist_percentile(&sim->latency, 0.99);
+    result->latency_p999 = hist_percentile(&sim->latency, 0.999);
+    result->stopped = sim->stopped;
+    result->converged = sim->converged;
+}
+
+/**
+ * Mensagens entregues por unidade de tempo simulado
+ */
+double run_goodput(const struct run_result *r) {
+    return r->time > 0 ? r->ntolayer5 / r->time : 0.0;
+}
+
+/**
+ * Reenvios por mensagem aceita pelo remetente
+ */
+double run_retransmit_ratio(const struct run_result *r) {
+    return r->naccepted > 0 ? (double)r->nretransmit / r->naccepted : 0.0;
+}
+
+/**
+ * Fração dos pacotes enviados ao meio (dados, ACKs e NAKs) que entregou
+ * uma mensagem nova
+ */
+double run_efficiency(const struct run_result *r) {
+    return r->ntolayer3 > 0 ? (double)r->ntolayer5 / r->ntolayer3 : 0.0;
+}
+
+static void *pool_worker(void *arg) {
+    struct run_pool *pool = arg;
+    FILE *log = fopen("/dev/null", "w");
+
+    if (log == NULL) {
+        pthread_mutex_lock(&pool->lock);
+        pool->failed = 1;
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+
+    while (1) {
+        long index;
+
+        pthread_mutex_lock(&pool->lock);
+        index = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+
+        if (index >= pool->nruns) {
+            break;
+        }
+
+        pool->run(pool->arg, index, log);
+    }
+
+    fclose(log);
+
+    return NULL;
+}
+
+/**
+ * Executa @run(@arg, i, log) para cada i de 0 a @nruns - 1 em até @nthreads
+ * threads, cada uma pegando a próxima execução ainda não feita e com a saída
+ * das simulações em /dev/null. Retorna o número de threads usadas, 0 se
+ * nenhuma pôde ser criada ou se alguma não pôde abrir /dev/null.
+ */
+int run_pool(long nruns, int nthreads, run_fn run, void *arg) {
+    struct run_pool pool;
+    pthread_t *threads;
+    int started = 0;
+
+    pool.run = run;
+    pool.arg = arg;
+    pool.nruns = nruns;
+    pool.next = 0;
+    pool.failed = 0;
+    pthread_mutex_init(&pool.lock, NULL);
+
+    if (nthreads > nruns) {
+        nthreads = (int)nruns;
+    }
+
+    threads = malloc(nthreads * sizeof(pthread_t));
+
+    for (int i = 0; i < nthreads; i++) {
+        if (pthread_create(&threads[i], NULL, pool_worker, &pool) != 0) {
+            break;
+        }
+
+        started++;
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    free(threads);
+    pthread_mutex_destroy(&pool.lock);
+
+    return pool.failed ? 0 : started;
+}
+
+static void replicate_one(void *arg, long replication, FILE *log) {
+    struct replication_args *args = arg;
+    struct sim_config config = *args->config;
+
+    config.seed = replication_seed(args->config->seed, replication);
+    run_simulation(&config, args->protocol, log, &args->results[replication]);
+}
+
+/**
+ * Executa @replications replicações independentes de @config em @nthreads
+ * threads. Os resultados ficam na ordem das replicações, iguais para qualquer
+ * número de threads. Retorna 0 se as replicações não puderem ser executadas.
+ */
+int replicate(const struct sim_config *config, const struct protocol *protocol,
+              int replications, int nthreads, struct run_result *results) {
+    struct replication_args args = { config, protocol, results };
+
+    return run_pool(replications, nthreads, replicate_one, &args) > 0;
+}
+
+static void report_line(FILE *out, const char *name, const struct summary *s) {
+    double ci = summary_ci95(s);
+
+    fprintf(out, "%-18s %14g %14g   [%g, %g]\n", name, s->mean, summary_variance(s),
+        s->mean - ci, s->mean + ci);
+}
+
+/**
+ * Imprime média, variância e intervalo de confiança de 95% de cada métrica,
+ * tratando cada replicação como uma observação independente
+ */
+void replication_report(FILE *out, const struct sim_config *config, const struct protocol *protocol,
+                        const struct run_result *results, int replications) {
+    struct summary goodput, retransmit, latency, latency_p99, tolayer3, lost, corrupt;
+    int stopped = 0, converged = 0;
+
+    summary_init(&goodput);
+    summary_init(&retransmit);
+    summary_init(&latency);
+    summary_init(&latency_p99);
+    summary_init(&tolayer3);
+    summary_init(&lost);
+    summary_init(&corrupt);
+
+    for (int i = 0; i < replications; i++) {
+        const struct run_result *r = &results[i];
+
+        summary_add(&goodput, run_goodput(r));
+        summary_add(&retransmit, run_retransmit_ratio(r));
+        summary_add(&latency, r->latency);
+        summary_add(&latency_p99, r->latency_p99);
+        summary_add(&tolayer3, r->ntolayer3);
+        summary_add(&lost, r->nlost);
+        summary_add(&corrupt, r->ncorrupt);
+        stopped += r->stopped;
+        converged += r->converged;
+    }
+
+    if (config->precision > 0) {
+        fprintf(out, "%s: %d of %d replications converged to %s within %g%% (loss %g, corruption %g, lambda %g, seed %u)\n\n",
+            protocol->name, converged, replications, config->metric == METRIC_LATENCY ? "latency" : "goodput",
+            config->precision * 100, config->lossprob, config->corruptprob, config->lambda, config->seed);
+    } else {
+        fprintf(out, "%s: %d replications of %lld messages (loss %g, corruption %g, lambda %g, seed %u)\n\n",
+            protocol->name, replications, config->nsimmax, config->lossprob, config->corruptprob,
+            config->lambda, config->seed);
+    }
+    fprintf(out, "%-18s %14s %14s   %s\n", "metric", "mean", "variance", "95% CI");
+    report_line(out, "goodput", &goodput);
+    report_line(out, "retransmit ratio", &retransmit);
+    report_line(out, "latency", &latency);
+    report_line(out, "latency p99", &latency_p99);
+    report_line(out, "tolayer3", &tolayer3);
+    report_line(out, "lost", &lost);
+    report_line(out, "corrupted", &corrupt);
+
+    if (stopped > 0) {
+        fprintf(out, "\n%d of %d replications stopped at max time\n", stopped, replications);
+    }
+
+    if (config->precision > 0 && converged < replications) {
+        fprintf(out, "\nWarning: %d replications stopped at the message cap (%lld) or max time before"
+            " reaching the precision\n", replications - converged, config->nsimmax);
+    }
+}
+
+/***********************************************/
+/*           MACHINE-READABLE SUMMARY          */
+/***********************************************/
+
+/**
+ * Um campo do resumo: contadores são impressos como inteiros
+ */
+struct summary_field {
+    const char *name;
+    double value;
+    int integer;
+};
+
+#define SUMMARY_FIELDS      28
+
+static void summary_fields(const struct run_result *r, int replication, struct summary_field f[SUMMARY_FIELDS]) {
+    const struct summary_field fields[SUMMARY_FIELDS] = {
+        { "replication",        replication,                               1 },
+        { "seed",               r->seed,                                   1 },
+        { "time",               r->time,                                   0 },
+        { "generated",          r->nsim,                                   1 },
+        { "offered_load",       r->time > 0 ? r->nsim / r->time : 0.0,     0 },
+        { "accepted",           r->naccepted,                              1 },
+        { "dropped_at_sender",  r->nsim - r->naccepted,                    1 },
+        { "delivered",          r->ntolayer5,                              1 },
+        { "goodput",            run_goodput(r),                            0 },
+        { "tolayer3",           r->ntolayer3,                              1 },
+        { "data_packets",       r->ndata,                                  1 },
+        { "lost",               r->nlost,                                  1 },
+        { "corrupted",          r->ncorrupt,                               1 },
+        { "undetected",         r->nundetected,                            1 },
+        { "efficiency",         run_efficiency(r),                         0 },
+        { "retransmissions",    r->nretransmit,                            1 },
+        { "retransmit_ratio",   run_retransmit_ratio(r),                   0 },
+        { "timeouts",           r->ntimeout,                               1 },
+        { "naks",               r->nnak,                                   1 },
+        { "latency",            r->latency,                                0 },
+        { "latency_p50",        r->latency_p50,                            0 },
+        { "latency_p99",        r->latency_p99,                            0 },
+        { "latency_p999",       r->latency_p999,                           0 },
+        { "events",             r->nevents,                                1 },
+        { "wall_time",          r->wall_time,                              0 },
+        { "events_per_second",  r->wall_time > 0 ? r->nevents / r->wall_time : 0.0, 0 },
+        { "stopped",            r->stopped,                                1 },
+        { "converged",          r->converged,                              1 },
+    };
+
+    memcpy(f, fields, sizeof(fields));
+}
+
+static void summary_value(FILE *out, const struct summary_field *f) {
+    if (f->integer) {
+        fprintf(out, "%lld", (long long)f->value);
+    } else {
+        fprintf(out, "%.9g", f->value);
+    }
+}
+
+/**
+ * Escreve em @out o resumo de cada execução para outros programas: em JSON
+ * (um objeto, ou uma lista deles com mais de uma execução) ou em CSV (uma
+ * linha por execução), no formato config->summary_format
+ */
+void run_summary(FILE *out, const struct sim_config *config, const struct protocol *protocol,
+                 const struct run_result *results, int nresults) {
+    struct summary_field f[SUMMARY_FIELDS];
+
+    if (config->summary_format == SUMMARY_CSV) {
+        summary_fields(&results[0], 0, f);
+        fprintf(out, "protocol,loss,corrupt,lambda");
+
+        for (int i = 0; i < SUMMARY_FIELDS; i++) {
+            fprintf(out, ",%s", f[i].name);
+        }
+
+        fprintf(out, "\n");
+    } else if (nresults > 1) {
+        fprintf(out, "[\n");
+    }
+
+    for (int run = 0; run < nresults; run++) {
+        summary_fields(&results[run], run, f);
+
+        if (config->summary_format == SUMMARY_CSV) {
+            fprintf(out, "%s,%g,%g,%g", protocol->name, config->lossprob, config->corruptprob, config->lambda);
+
+            for (int i = 0; i < SUMMARY_FIELDS; i++) {
+                fprintf(out, ",");
+                summary_value(out, &f[i]);
+            }
+
+            fprintf(out, "\n");
+            continue;
+        }
+
+        fprintf(out, "{\"protocol\": \"%s\", \"loss\": %g, \"corrupt\": %g, \"lambda\": %g",
+            protocol->name, config->lossprob, config->corruptprob, config->lambda);
+
+        for (int i = 0; i < SUMMARY_FIELDS; i++) {
+            fprintf(out, ", \"%s\": ", f[i].name);
+            summary_value(out, &f[i]);
+        }
+
+        fprintf(out, "}%s\n", run < nresults - 1 ? "," : "");
+    }
+
+    if (config->summary_format == SUMMARY_JSON && nresults > 1) {
+        fprintf(out, "]\n");
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include <stdio.h>
+
+#include "config.h"
+#include "emulator.h"
+#include "simulation.h"
+
+/**
+ * Resultado de uma execução
+ *
+ * @seed: semente usada
+ * @time: instante em que a simulação terminou
+ * @nsim: mensagens geradas pela camada 5 de A
+ * @naccepted: mensagens aceitas pelo remetente
+ * @ntolayer5: mensagens entregues à camada 5 de B
+ * @ntolayer3, @nlost, @ncorrupt: pacotes enviados, perdidos e corrompidos
+ * @nundetected: pacotes corrompidos que o checksum não detectou
+ * @nretransmit: pacotes reenviados pelo remetente
+ * @ndata: pacotes de dados enviados pelo remetente, contando os reenvios
+ * @nnak, @ntimeout: NAKs enviados e timers do remetente estourados
+ * @nevents: eventos processados
+ * @wall_time: segundos de tempo real que a simulação levou
+ * @latency: atraso médio entre a aceitação e a entrega de uma mensagem
+ * @latency_p50, @latency_p99, @latency_p999: percentis 50, 99 e 99,9 do atraso
+ * @stopped: execução cortada em max_time (ou que não pôde ser iniciada)
+ * @converged: com --precision, a estimativa atingiu a precisão pedida (e não
+ *             o limite de mensagens ou max_time)
+ */
+struct run_result {
+    unsigned int seed;
+    double time;
+    long long nsim;
+    long long naccepted;
+    long long ntolayer5;
+    long long ntolayer3;
+    long long nlost;
+    long long ncorrupt;
+    long long nundetected;
+    long long nretransmit;
+    long long ndata;
+    long long nnak;
+    long long ntimeout;
+    long long nevents;
+    double wall_time;
+    double latency;
+    double latency_p50;
+    double latency_p99;
+    double latency_p999;
+    int stopped;
+    int converged;
+};
+
+unsigned int replication_seed(unsigned int seed, long replication);
+void run_collect(const struct simulation *sim, struct run_result *result);
+void run_simulation(const struct sim_config *config, const struct protocol *protocol,
+                    FILE *log, struct run_result *result);
+double run_goodput(const struct run_result *r);
+double run_retransmit_ratio(const struct run_result *r);
+double run_efficiency(const struct run_result *r);
+void run_summary(FILE *out, const struct sim_config *config, const struct protocol *protocol,
+                 const struct run_result *results, int nresults);
+
+/* one run of a pool: @index from 0 to nruns - 1, simulator output to @log */
+typedef void (*run_fn)(void *arg, long index, FILE *log);
+
+int run_pool(long nruns, int nthreads, run_fn run, void *arg);
+int replicate(const struct sim_config *config, const struct protocol *protocol,
+              int replications, int nthreads, struct run_result *results);
+void replication_report(FILE *out, const struct sim_config *config, const struct protocol *protocol,
+                        const struct run_result *results, int replications);
+
+#endif
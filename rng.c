@@ -0,0 +1,85 @@
+#include <string.h>
+
+#include "rng.h"
+
+/***********************************************/
+/*           RANDOM NUMBER GENERATORS          */
+/***********************************************/
+
+static const char *rng_names[] = { "xoshiro", "legacy" };
+
+const char *rng_name(int kind) {
+    if (kind < RNG_XOSHIRO || kind > RNG_LEGACY) {
+        return "unknown";
+    }
+
+    return rng_names[kind];
+}
+
+/**
+ * Converte o nome de um gerador para o código RNG_*, -1 se não existir
+ */
+int rng_parse(const char *name) {
+    for (int i = RNG_XOSHIRO; i <= RNG_LEGACY; i++) {
+        if (strcmp(name, rng_names[i]) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
+
+/**
+ * Inicializa o gerador. O estado do xoshiro256** é preenchido pelo splitmix64
+ * a partir da semente, como recomendam os autores (nunca fica todo zerado).
+ */
+void rng_seed(struct rng *rng, int kind, unsigned int seed) {
+    uint64_t x = seed;
+
+    memset(rng, 0, sizeof(*rng));
+    rng->kind = kind;
+
+    if (kind == RNG_LEGACY) {
+        initstate_r(seed, (char *)rng->legacy_state, sizeof(rng->legacy_state), &rng->legacy);
+        return;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix64(&x);
+    }
+}
+
+/**
+ * Avança o xoshiro256** 2^128 números: gerador copiado e avançado forma uma
+ * sequência independente, que não se sobrepõe à original
+ */
+void rng_jump(struct rng *rng) {
+    static const uint64_t jump[] = {
+        0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+    };
+    uint64_t s[4] = { 0, 0, 0, 0 };
+
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & (1ULL << b)) {
+                s[0] ^= rng->s[0];
+                s[1] ^= rng->s[1];
+                s[2] ^= rng->s[2];
+                s[3] ^= rng->s[3];
+            }
+
+            xoshiro_next(rng);
+        }
+    }
+
+    memcpy(rng->s, s, sizeof(s));
+}
@@ -0,0 +1,66 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/* available generators: */
+#define RNG_XOSHIRO        0   /* xoshiro256** (Blackman & Vigna, 2018) */
+#define RNG_LEGACY         1   /* same sequence as srand()/rand() */
+
+/**
+ * Gerador de números aleatórios de uma simulação
+ *
+ * @kind: gerador escolhido (RNG_*)
+ * @s: estado do xoshiro256**
+ * @legacy, @legacy_state: estado do random_r() (RNG_LEGACY)
+ */
+struct rng {
+    int kind;
+    uint64_t s[4];
+    struct random_data legacy;
+    int32_t legacy_state[32];
+};
+
+const char *rng_name(int kind);
+int rng_parse(const char *name);
+void rng_seed(struct rng *rng, int kind, unsigned int seed);
+void rng_jump(struct rng *rng);
+
+static inline uint64_t rng_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t xoshiro_next(struct rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * Número uniforme em [0,1]: com RNG_XOSHIRO, os 24 bits mais altos (toda a
+ * precisão de um float, sempre menor que 1); com RNG_LEGACY, rand() / RAND_MAX
+ * exatamente como o jimsrand() original
+ */
+static inline float rng_uniform(struct rng *rng) {
+    int32_t r;
+
+    if (rng->kind == RNG_XOSHIRO) {
+        return (float)(xoshiro_next(rng) >> 40) * 0x1.0p-24f;
+    }
+
+    random_r(&rng->legacy, &r);
+
+    return (float)(r / (double)RAND_MAX);
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include <string.h>
+
+#include "rto.h"
+
+/***********************************************/
+/*          RETRANSMISSION TIMEOUT             */
+/***********************************************/
+
+/* the shortest possible round trip: at least 1 time unit each way */
+#define RTO_MIN            2.0
+/* backoff stops doubling at this multiple of the initial timeout */
+#define RTO_MAX_FACTOR     64.0
+
+static const char *rto_names[] = { "fixed", "adaptive" };
+
+const char *rto_name(int kind) {
+    if (kind < RTO_FIXED || kind > RTO_ADAPTIVE) {
+        return "unknown";
+    }
+
+    return rto_names[kind];
+}
+
+/**
+ * Converte o nome de uma política para o código RTO_*, -1 se não existir
+ */
+int rto_parse(const char *name) {
+    for (int i = RTO_FIXED; i <= RTO_ADAPTIVE; i++) {
+        if (strcmp(name, rto_names[i]) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void rto_init(struct rto *r, int kind, double initial) {
+    r->kind = kind;
+    r->initial = initial;
+    r->srtt = 0.0;
+    r->rttvar = 0.0;
+    r->rto = initial;
+    r->has_sample = 0;
+}
+
+static double rto_clamp(const struct rto *r, double rto) {
+    if (rto < RTO_MIN) {
+        return RTO_MIN;
+    }
+
+    if (rto > RTO_MAX_FACTOR * r->initial) {
+        return RTO_MAX_FACTOR * r->initial;
+    }
+
+    return rto;
+}
+
+/**
+ * Atualiza a estimativa com uma amostra de RTT (RFC 6298, seção 2)
+ */
+void rto_sample(struct rto *r, double rtt) {
+    double delta;
+
+    if (r->kind != RTO_ADAPTIVE) {
+        return;
+    }
+
+    if (!r->has_sample) {
+        r->srtt = rtt;
+        r->rttvar = rtt / 2;
+        r->has_sample = 1;
+    } else {
+        delta = r->srtt - rtt;
+        r->rttvar = 0.75 * r->rttvar + 0.25 * (delta < 0 ? -delta : delta);
+        r->srtt = 0.875 * r->srtt + 0.125 * rtt;
+    }
+
+    r->rto = rto_clamp(r, r->srtt + 4 * r->rttvar);
+}
+
+/**
+ * Dobra o timeout depois de uma expiração (RFC 6298, seção 5.5)
+ */
+void rto_backoff(struct rto *r) {
+    if (r->kind != RTO_ADAPTIVE) {
+        return;
+    }
+
+    r->rto = rto_clamp(r, 2 * r->rto);
+}
+
+/**
+ * Timeout de um pacote já reenviado @retries vezes, para protocolos com um
+ * timer por pacote: o backoff fica em cada pacote e não na estimativa comum
+ */
+double rto_backed_off(const struct rto *r, int retries) {
+    double rto = r->rto;
+
+    if (r->kind != RTO_ADAPTIVE) {
+        return rto;
+    }
+
+    for (int i = 0; i < retries && rto < RTO_MAX_FACTOR * r->initial; i++) {
+        rto *= 2;
+    }
+
+    return rto_clamp(r, rto);
+}
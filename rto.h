@@ -0,0 +1,43 @@
+#ifndef RTO_H
+#define RTO_H
+
+/* retransmission timeout policies: */
+#define RTO_FIXED          0   /* always --rtt (original behaviour) */
+#define RTO_ADAPTIVE       1   /* SRTT/RTTVAR estimate with backoff (RFC 6298) */
+
+/**
+ * Timeout de retransmissão de um remetente
+ *
+ * Com RTO_ADAPTIVE o timeout é SRTT + 4 * RTTVAR, estimado a partir das
+ * amostras de RTT que o protocolo informa. Pela regra de Karn, o protocolo
+ * só informa amostras de pacotes que não foram reenviados. A cada timeout o
+ * valor dobra (backoff exponencial) até a próxima amostra. Com RTO_FIXED o
+ * timeout é sempre @initial.
+ *
+ * @kind: política (RTO_*)
+ * @initial: timeout antes da primeira amostra (--rtt)
+ * @srtt, @rttvar: média e variação suavizadas do RTT
+ * @rto: timeout atual
+ * @has_sample: já houve alguma amostra
+ */
+struct rto {
+    int kind;
+    double initial;
+    double srtt;
+    double rttvar;
+    double rto;
+    int has_sample;
+};
+
+const char *rto_name(int kind);
+int rto_parse(const char *name);
+void rto_init(struct rto *r, int kind, double initial);
+void rto_sample(struct rto *r, double rtt);
+void rto_backoff(struct rto *r);
+double rto_backed_off(const struct rto *r, int retries);
+
+static inline double rto_timeout(const struct rto *r) {
+    return r->rto;
+}
+
+#endif
@@ -0,0 +1,523 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "checksum.h"
+#include "emulator.h"
+#include "rto.h"
+#include "simulation.h"
+#include "trace.h"
+
+/***********************************************/
+/*    STUDENTS WRITE THE NEXT SEVEN ROUTINES   */
+/***********************************************/
+
+/* valores usados quando --rtt, --window e --buffer não são informados */
+#define RTT                 50.0
+#define SENDER_WINDOW_SIZE  8
+#define SENDER_BUFFER_SIZE  25
+#define DEADLINES_INITIAL_CAPACITY  16
+
+/* number of the message a packet carries (seqnums start at 1, one per message) */
+#define MESSAGE(seqnum)     ((seqnum) - 1)
+
+/**
+ * Posição do buffer do remetente: o pacote, se já recebeu ACK e, se foi
+ * enviado, quantas vezes foi reenviado (sem amostra de RTT pela regra de
+ * Karn, e com o timeout dobrado a cada vez), quando foi enviado pela última
+ * vez e quando o seu timer lógico expira
+ */
+struct envio {
+    struct pkt packet;
+    int acked;
+    int retransmissions;
+    double sent_at;
+    double deadline;
+};
+
+/**
+ * Timer lógico armado: o pacote @seqnum expira em @deadline. Fica obsoleto
+ * (e é descartado quando chega ao topo do heap) se o pacote recebe ACK ou é
+ * reenviado, o que lhe dá outro prazo.
+ */
+struct prazo {
+    double deadline;
+    seqnum_t seqnum;
+};
+
+/**
+ * Estrutura do remetente
+ *
+ * O buffer é circular como no Go-Back-N: o pacote de seqnum s fica na posição
+ * s % buffer_capacity, e os pacotes no buffer são os de seqnum base até
+ * next_seqnum - 1. Cada pacote enviado tem o seu próprio timer lógico; o único
+ * timer do emulador fica armado para o que expira primeiro, o topo de um heap
+ * de prazos. Com timeout fixo os prazos são armados em ordem crescente, e cada
+ * inserção para na folha.
+ *
+ * @rto: Timeout de cada pacote (fixo ou estimado, --rto)
+ * @window_size: Tamanho da janela
+ * @base: Seqnum do pacote mais antigo no buffer, ainda sem ACK
+ * @next_seqnum: Seqnum do próximo pacote adicionado no buffer
+ * @next_to_send: Seqnum do primeiro pacote do buffer que ainda não foi enviado
+ * @buffer_capacity: Número de posições do buffer (pelo menos a janela)
+ * @buffer: Buffer circular com os pacotes
+ * @timer_running, @timer_deadline: Se o timer do emulador está armado, e para quando
+ * @deadlines: Heap mínimo dos timers lógicos, por prazo e depois por seqnum
+ * @ndeadlines, @deadlines_capacity: Tamanho e capacidade do heap
+ */
+struct remetente {
+    struct rto rto;
+    int window_size;
+    seqnum_t base;
+    seqnum_t next_seqnum;
+    seqnum_t next_to_send;
+    int buffer_capacity;
+    struct envio *buffer;
+    int timer_running;
+    double timer_deadline;
+    struct prazo *deadlines;
+    int ndeadlines;
+    int deadlines_capacity;
+};
+
+/**
+ * Posição do buffer de reordenação do receptor
+ */
+struct recebimento {
+    struct pkt packet;
+    int received;
+};
+
+/**
+ * Estrutura do receptor
+ *
+ * @base: Seqnum do próximo pacote a entregar para a camada 5
+ * @window_size: Tamanho da janela (a mesma do remetente)
+ * @buffer: Pacotes recebidos fora de ordem, na posição seqnum % window_size
+ */
+struct receptor {
+    seqnum_t base;
+    int window_size;
+    struct recebimento *buffer;
+};
+
+/**
+ * Estado do protocolo em uma simulação (sim->protocol_state)
+ */
+struct selective_repeat {
+    struct remetente A;
+    struct receptor B;
+};
+
+static inline struct remetente *sender(struct simulation *sim) {
+    return &((struct selective_repeat *)sim->protocol_state)->A;
+}
+
+static inline struct receptor *receiver(struct simulation *sim) {
+    return &((struct selective_repeat *)sim->protocol_state)->B;
+}
+
+/**
+ * Atualiza checksum de um pacote com o algoritmo de --checksum
+ */
+static void update_pkt_checksum(struct simulation *sim, struct pkt *packet) {
+    packet->checksum = pkt_checksum(sim->config.checksum, packet);
+}
+
+/**
+ * Verifica se o checksum do pacote é igual ao checksum esperado
+ */
+static int is_valid_checksum(struct simulation *sim, int expected_checksum, struct pkt *packet) {
+    return pkt_checksum(sim->config.checksum, packet) == expected_checksum;
+}
+
+/**
+ * Envia ACK para o meio
+ */
+static void send_ACK(struct simulation *sim, int AorB, seqnum_t seqnum) {
+    struct pkt packet = { 0 };
+    packet.acknum = seqnum;
+    update_pkt_checksum(sim, &packet);
+
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[send_ACK] Enviando (acknum: %lld)\n", seqnum);
+    tolayer3(sim, AorB, packet);
+}
+
+static struct envio *sender_slot(struct remetente *A, seqnum_t seqnum) {
+    return &A->buffer[seqnum % A->buffer_capacity];
+}
+
+static struct recebimento *receiver_slot(struct receptor *B, seqnum_t seqnum) {
+    return &B->buffer[seqnum % B->window_size];
+}
+
+static int deadline_before(const struct prazo *a, const struct prazo *b) {
+    return a->deadline < b->deadline || (a->deadline == b->deadline && a->seqnum < b->seqnum);
+}
+
+static void deadline_push(struct remetente *A, double deadline, seqnum_t seqnum) {
+    int i;
+
+    if (A->ndeadlines == A->deadlines_capacity) {
+        A->deadlines_capacity = A->deadlines_capacity ? 2 * A->deadlines_capacity : DEADLINES_INITIAL_CAPACITY;
+        A->deadlines = realloc(A->deadlines, A->deadlines_capacity * sizeof(struct prazo));
+
+        if (A->deadlines == NULL) {
+            printf("INTERNAL PANIC: out of memory growing the sender timers\n");
+            exit(1);
+        }
+    }
+
+    i = A->ndeadlines++;
+    A->deadlines[i].deadline = deadline;
+    A->deadlines[i].seqnum = seqnum;
+
+    while (i > 0 && deadline_before(&A->deadlines[i], &A->deadlines[(i - 1) / 2])) {
+        struct prazo t = A->deadlines[i];
+
+        A->deadlines[i] = A->deadlines[(i - 1) / 2];
+        A->deadlines[(i - 1) / 2] = t;
+        i = (i - 1) / 2;
+    }
+}
+
+static void deadline_pop(struct remetente *A) {
+    int i = 0;
+
+    A->deadlines[0] = A->deadlines[--A->ndeadlines];
+
+    while (1) {
+        int child = 2 * i + 1;
+
+        if (child >= A->ndeadlines) {
+            break;
+        }
+
+        if (child + 1 < A->ndeadlines && deadline_before(&A->deadlines[child + 1], &A->deadlines[child])) {
+            child++;
+        }
+
+        if (!deadline_before(&A->deadlines[child], &A->deadlines[i])) {
+            break;
+        }
+
+        struct prazo t = A->deadlines[i];
+
+        A->deadlines[i] = A->deadlines[child];
+        A->deadlines[child] = t;
+        i = child;
+    }
+}
+
+/**
+ * Timer lógico que expira primeiro entre os pacotes enviados e sem ACK, ou
+ * NULL se não houver nenhum, descartando do topo os prazos obsoletos
+ */
+static struct prazo *first_deadline(struct remetente *A) {
+    while (A->ndeadlines > 0) {
+        struct prazo *top = &A->deadlines[0];
+        struct envio *slot = sender_slot(A, top->seqnum);
+
+        if (top->seqnum >= A->base && top->seqnum < A->next_to_send
+                && !slot->acked && slot->deadline == top->deadline) {
+            return top;
+        }
+
+        deadline_pop(A);
+    }
+
+    return NULL;
+}
+
+/**
+ * Arma o timer do emulador para o timer lógico que expira primeiro, ou
+ * desliga se não houver nenhum
+ */
+static void rearm_timer(struct simulation *sim) {
+    struct remetente *A = sender(sim);
+    struct prazo *first = first_deadline(A);
+
+    if (A->timer_running && first != NULL && first->deadline == A->timer_deadline) {
+        return;
+    }
+
+    if (A->timer_running) {
+        stoptimer(sim, 0);
+        A->timer_running = 0;
+    }
+
+    if (first != NULL) {
+        starttimer(sim, 0, first->deadline - sim->time);
+        A->timer_running = 1;
+        A->timer_deadline = first->deadline;
+    }
+}
+
+/**
+ * Envia (ou reenvia) um pacote do buffer e inicia o seu timer lógico
+ */
+static void send_packet(struct simulation *sim, seqnum_t seqnum) {
+    struct remetente *A = sender(sim);
+    struct envio *slot = sender_slot(A, seqnum);
+
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[send_packet] Sending (pkt: %lld, payload: %s)\n", seqnum, slot->packet.payload);
+
+    slot->sent_at = sim->time;
+    slot->deadline = sim->time + rto_backed_off(&A->rto, slot->retransmissions);
+    deadline_push(A, slot->deadline, seqnum);
+    data_sent(sim, MESSAGE(seqnum), slot->retransmissions > 0);
+    tolayer3(sim, 0, slot->packet);
+}
+
+/**
+ * Envia os pacotes do buffer que entraram na janela e ainda não foram enviados
+ */
+static void send_new_packets(struct simulation *sim) {
+    struct remetente *A = sender(sim);
+    seqnum_t window_end = A->base + A->window_size < A->next_seqnum ? A->base + A->window_size : A->next_seqnum;
+
+    for (; A->next_to_send < window_end; A->next_to_send++) {
+        send_packet(sim, A->next_to_send);
+    }
+}
+
+/***********************************************/
+/*                  REMETENTE                  */
+/***********************************************/
+
+/**
+ * Inicializa remetente
+ */
+static void A_init(struct simulation *sim) {
+    struct remetente *A = sender(sim);
+
+    rto_init(&A->rto, sim->config.rto, sim->config.rtt > 0 ? sim->config.rtt : RTT);
+    A->window_size = sim->config.window_size > 0 ? sim->config.window_size : SENDER_WINDOW_SIZE;
+    A->buffer_capacity = sim->config.buffer_size > 0 ? sim->config.buffer_size : SENDER_BUFFER_SIZE;
+
+    if (A->buffer_capacity < A->window_size) {
+        A->buffer_capacity = A->window_size;
+    }
+
+    A->buffer = calloc(A->buffer_capacity, sizeof(struct envio));
+    A->base = 1;
+    A->next_seqnum = 1;
+    A->next_to_send = 1;
+    A->timer_running = 0;
+    A->deadlines = NULL;
+    A->ndeadlines = 0;
+    A->deadlines_capacity = 0;
+}
+
+/**
+ * Chamado quando o timer do remetente é estourado
+ *
+ * Reenvia só os pacotes cujo timer lógico expirou (com --rto adaptive, com o
+ * timeout do pacote dobrado) e rearma o timer para o próximo a expirar
+ */
+static void A_timerinterrupt(struct simulation *sim) {
+    struct remetente *A = sender(sim);
+    double expired = A->timer_deadline;
+    struct prazo *first;
+
+    A->timer_running = 0;
+
+    /* resent packets get a later deadline, so this stops at the ones expired now */
+    while ((first = first_deadline(A)) != NULL && first->deadline <= expired) {
+        seqnum_t seqnum = first->seqnum;
+
+        deadline_pop(A);
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[A_timerinterrupt] Timeout, reenviando (pkt: %lld)\n", seqnum);
+
+        sender_slot(A, seqnum)->retransmissions++;
+        send_packet(sim, seqnum);
+    }
+
+    rearm_timer(sim);
+}
+
+/**
+ * Recebe mensagem da camada aplicação
+ *
+ * 1. Se o buffer já estiver cheio, descarta a mensagem
+ * 2. Adiciona o pacote no buffer
+ * 3. Envia o pacote, se ele estiver dentro da janela
+ *
+ * Retorna 0 se a mensagem foi descartada.
+ */
+static int A_output(struct simulation *sim, struct msg message) {
+    struct remetente *A = sender(sim);
+
+    if (A->next_seqnum - A->base >= A->buffer_capacity) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[A_output] Buffer cheio, descartando pacote\n");
+        return 0;
+    }
+
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[A_output] Mensagem recebida, adicionando pacote ao buffer (pkt: %lld, payload: %s)\n", A->next_seqnum, message.data);
+
+    struct envio *slot = sender_slot(A, A->next_seqnum);
+    struct pkt packet = { 0 };
+    packet.seqnum = A->next_seqnum;
+
+    for (int i = 0; i < 20; i++) {
+        packet.payload[i] = message.data[i];
+    }
+
+    update_pkt_checksum(sim, &packet);
+
+    slot->packet = packet;
+    slot->acked = 0;
+    slot->retransmissions = 0;
+    A->next_seqnum++;
+
+    send_new_packets(sim);
+    rearm_timer(sim);
+
+    return 1;
+}
+
+/**
+ * Recebe pacote do meio
+ *
+ * 1. Se o pacote está corrompido, descarta pacote
+ * 2. Marca o pacote do ACK como recebido
+ * 3. Se ele era a base, desliza a janela até o primeiro pacote sem ACK
+ *    e envia os pacotes que entraram na janela
+ */
+static void A_input(struct simulation *sim, struct pkt packet) {
+    struct remetente *A = sender(sim);
+
+    if (!is_valid_checksum(sim, packet.checksum, &packet)) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[A_input] Pacote recebido corrompido, descartando\n");
+        return;
+    }
+
+    if (packet.acknum < A->base || packet.acknum >= A->next_to_send) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[A_input] ACK fora da janela, descartando (acknum: %lld)\n", packet.acknum);
+        return;
+    }
+
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[A_input] ACK recebido (pkt: %lld)\n", packet.acknum);
+
+    struct envio *slot = sender_slot(A, packet.acknum);
+
+    if (slot->acked) {
+        return;
+    }
+
+    if (slot->retransmissions == 0) {
+        rto_sample(&A->rto, sim->time - slot->sent_at);
+    }
+
+    slot->acked = 1;
+
+    while (A->base < A->next_to_send && sender_slot(A, A->base)->acked) {
+        A->base++;
+    }
+
+    send_new_packets(sim);
+    rearm_timer(sim);
+}
+
+/***********************************************/
+/*                   RECEPTOR                  */
+/***********************************************/
+
+/**
+ * Inicializa receptor
+ */
+static void B_init(struct simulation *sim) {
+    struct receptor *B = receiver(sim);
+
+    B->window_size = sim->config.window_size > 0 ? sim->config.window_size : SENDER_WINDOW_SIZE;
+    B->buffer = calloc(B->window_size, sizeof(struct recebimento));
+    B->base = 1;
+}
+
+/**
+ * Chamado quando o timer do receptor é estourado
+ * (Não utilizado)
+ */
+static void B_timerinterrupt(struct simulation *sim) {
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[B_timerinterrupt] Não implementado\n");
+}
+
+/**
+ * Recebe mensagem da camada aplicação
+ * (Não utilizado)
+ */
+static int B_output(struct simulation *sim, struct msg message) {
+    (void)message;
+    TRACE_LOG(sim, TRACE_PROTOCOL, "[B_output] Não implementado\n");
+    return 0;
+}
+
+/**
+ * Recebe pacote do meio
+ *
+ * 1. Se o pacote está corrompido, descarta (o timer do remetente o reenvia)
+ * 2. Se o pacote é de antes da janela, já foi entregue: reenvia o ACK
+ * 3. Se está dentro da janela, manda ACK e guarda no buffer de reordenação
+ * 4. Entrega para a camada de aplicação os pacotes em ordem a partir da base
+ */
+static void B_input(struct simulation *sim, struct pkt packet) {
+    struct receptor *B = receiver(sim);
+
+    if (!is_valid_checksum(sim, packet.checksum, &packet)) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] Pacote recebido corrompido, descartando\n");
+        return;
+    }
+
+    if (packet.seqnum < B->base) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] Pacote já entregue, reenviando ACK (pkt: %lld)\n", packet.seqnum);
+        send_ACK(sim, 1, packet.seqnum);
+        return;
+    }
+
+    if (packet.seqnum >= B->base + B->window_size) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] Pacote fora da janela, descartando (pkt: %lld, base: %lld)\n", packet.seqnum, B->base);
+        return;
+    }
+
+    send_ACK(sim, 1, packet.seqnum);
+
+    struct recebimento *slot = receiver_slot(B, packet.seqnum);
+
+    if (!slot->received) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] Pacote recebido, guardando no buffer (pkt: %lld, payload: %s)\n", packet.seqnum, packet.payload);
+
+        slot->packet = packet;
+        slot->received = 1;
+    }
+
+    while ((slot = receiver_slot(B, B->base))->received) {
+        TRACE_LOG(sim, TRACE_PROTOCOL, "[B_input] Entregando pacote (pkt: %lld)\n", B->base);
+
+        tolayer5(sim, 1, slot->packet.payload);
+        slot->received = 0;
+        B->base++;
+    }
+}
+
+/**
+ * Libera os buffers alocados em A_init e B_init
+ */
+static void destroy(struct simulation *sim) {
+    free(sender(sim)->buffer);
+    free(sender(sim)->deadlines);
+    free(receiver(sim)->buffer);
+}
+
+const struct protocol selective_repeat_protocol = {
+    .name = "sr",
+    .state_size = sizeof(struct selective_repeat),
+    .A_init = A_init,
+    .A_output = A_output,
+    .A_input = A_input,
+    .A_timerinterrupt = A_timerinterrupt,
+    .B_init = B_init,
+    .B_output = B_output,
+    .B_input = B_input,
+    .B_timerinterrupt = B_timerinterrupt,
+    .destroy = destroy,
+};
@@ -0,0 +1,126 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bintrace.h"
+#include "config.h"
+#include "emulator.h"
+#include "event_queue.h"
+#include "histogram.h"
+#include "pool.h"
+#include "rng.h"
+#include "stats.h"
+
+/* random streams, one per stochastic source, so that the draws of one */
+/* source do not depend on how many numbers the others have used */
+#define STREAM_ARRIVAL     0   /* message arrivals from layer 5 */
+#define STREAM_LOSS        1   /* packet losses */
+#define STREAM_DELAY       2   /* packet delays in the medium */
+#define STREAM_CORRUPT     3   /* packet corruptions (whether and which field) */
+#define NSTREAMS           4
+
+/**
+ * Mensagem aceita pelo remetente e ainda não entregue
+ *
+ * @arrival: instante em que chegou da camada 5
+ * @first_sent: instante em que foi enviada pela primeira vez, -1 enquanto
+ *              espera no buffer do remetente
+ * @retransmissions: vezes que foi reenviada até agora
+ */
+struct pending_msg {
+    double arrival;
+    double first_sent;
+    int retransmissions;
+};
+
+/**
+ * Estado de uma simulação. Nada do emulador nem dos protocolos fica em
+ * variáveis globais, então simulações diferentes podem rodar ao mesmo tempo
+ * em threads diferentes.
+ *
+ * @config: parâmetros da execução
+ * @protocol: rotinas do protocolo simulado
+ * @protocol_state: estado do protocolo (remetente e receptor)
+ * @log: destino da saída do simulador e do trace em texto
+ * @trace: nível de trace
+ * @evqueue: conjunto de eventos futuros
+ * @evseq: número de eventos inseridos até agora
+ * @event_pool: eventos (com a cópia do pacote) reaproveitados
+ * @timers, @timer_running: o timer de cada entidade, fora da fila
+ * @inflight_head, @inflight_tail: pacotes no meio indo para cada entidade
+ * @rng: geradores das sequências aleatórias
+ * @stream: gerador de cada fonte (STREAM_*); com RNG_LEGACY todas usam o mesmo,
+ *          como no emulador original
+ * @pending: mensagens aceitas e ainda não entregues (fila circular, na ordem
+ *           de aceitação); @pending_first é o número da que está no início
+ * @latency: atraso de cada mensagem entregue, da chegada da camada 5 à entrega
+ * @buffer_wait: espera de cada mensagem no buffer do remetente até o primeiro envio
+ * @retransmissions: reenvios de cada mensagem até a entrega
+ * @batches: médias por lote das entregas, para --precision
+ * @converged: a estimativa pedida com --precision atingiu a precisão
+ * @bintrace: trace binário (desligado se bintrace.file for NULL)
+ */
+struct simulation {
+    struct sim_config config;
+    const struct protocol *protocol;
+    void *protocol_state;
+    FILE *log;
+    int trace;
+
+    struct event_queue evqueue;
+    unsigned long evseq;
+    struct pool event_pool;
+    struct event timers[2];
+    int timer_running[2];
+    struct event *inflight_head[2];
+    struct event *inflight_tail[2];
+
+    struct rng rng[NSTREAMS];
+    struct rng *stream[NSTREAMS];
+
+    double time;
+    long long nsim;             /* number of messages from 5 to 4 so far */
+    long long nsimmax;          /* number of msgs to generate, then stop */
+    double lossprob;            /* probability that a packet is dropped  */
+    double corruptprob;         /* probability that one bit is packet is flipped */
+    double lambda;              /* arrival rate of messages from layer 5 */
+    long long ntolayer3;        /* number sent into layer 3 */
+    long long nlost;            /* number lost in media */
+    long long ncorrupt;         /* number corrupted by media*/
+    long long nundetected;      /* corrupted but with a matching checksum */
+    long long ntolayer5;        /* number delivered to layer 5 */
+    long long naccepted;        /* number the sender took from layer 5 */
+    long long nretransmit;      /* number the sender sent again */
+    long long ndata;            /* data packets the sender sent */
+    long long nnak;             /* NAKs sent (by protocols that use them) */
+    long long ntimeout;         /* sender (A) timer interrupts */
+    long long nevents;          /* events processed */
+    double wall_time;           /* seconds of real time sim_run took */
+    int stopped;                /* stopped at max_time with events left */
+
+    struct pending_msg *pending;
+    int pending_head;
+    int pending_count;
+    int pending_capacity;
+    long long pending_first;
+    struct histogram latency;
+    struct histogram buffer_wait;
+    struct histogram retransmissions;
+    struct batch_means batches;
+    int converged;
+
+    struct bintrace bintrace;
+};
+
+int sim_init(struct simulation *sim, const struct sim_config *config,
+             const struct protocol *protocol, FILE *log);
+void sim_run(struct simulation *sim);
+void sim_destroy(struct simulation *sim);
+
+float jimsrand(struct simulation *sim, int stream);
+
+#endif
@@ -0,0 +1,115 @@
+#include <math.h>
+
+#include "stats.h"
+
+/***********************************************/
+/*            SUMMARY STATISTICS               */
+/***********************************************/
+
+/* two-sided 95% quantiles of Student's t for 1 to 30 degrees of freedom */
+static const double t95[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+void summary_init(struct summary *s) {
+    s->n = 0;
+    s->mean = 0.0;
+    s->m2 = 0.0;
+}
+
+void summary_add(struct summary *s, double x) {
+    double delta = x - s->mean;
+
+    s->n++;
+    s->mean += delta / s->n;
+    s->m2 += delta * (x - s->mean);
+}
+
+/**
+ * Variância amostral (divisor n - 1); 0 com menos de duas observações
+ */
+double summary_variance(const struct summary *s) {
+    return s->n > 1 ? s->m2 / (s->n - 1) : 0.0;
+}
+
+/**
+ * Meia largura do intervalo de confiança de 95% da média, supondo
+ * observações independentes e aproximadamente normais
+ */
+double summary_ci95(const struct summary *s) {
+    if (s->n < 2) {
+        return 0.0;
+    }
+
+    return student_t95(s->n - 1) * sqrt(summary_variance(s) / s->n);
+}
+
+/**
+ * Quantil 0.975 da distribuição t com @df graus de liberdade; acima de 30,
+ * os valores tabelados mais próximos por baixo (conservadores)
+ */
+double student_t95(long df) {
+    if (df < 1) {
+        return 0.0;
+    }
+
+    if (df <= 30) {
+        return t95[df - 1];
+    }
+
+    if (df < 40) {
+        return 2.042;
+    }
+
+    if (df < 60) {
+        return 2.021;
+    }
+
+    if (df < 120) {
+        return 2.000;
+    }
+
+    return df < 1000 ? 1.980 : 1.960;
+}
+
+void batch_init(struct batch_means *b, long size, long warmup) {
+    b->size = size;
+    b->warmup = warmup;
+    b->seen = 0;
+    b->count = 0;
+    b->start = 0.0;
+    b->latency_sum = 0.0;
+    summary_init(&b->goodput);
+    summary_init(&b->latency);
+}
+
+/**
+ * Registra uma entrega no instante @time com atraso @latency. Retorna 1 se
+ * ela fechou um lote.
+ */
+int batch_add(struct batch_means *b, double time, double latency) {
+    if (b->seen++ < b->warmup) {
+        b->start = time;
+        return 0;
+    }
+
+    b->latency_sum += latency;
+
+    if (++b->count < b->size) {
+        return 0;
+    }
+
+    if (time > b->start) {
+        summary_add(&b->goodput, b->count / (time - b->start));
+    }
+
+    summary_add(&b->latency, b->latency_sum / b->count);
+
+    b->count = 0;
+    b->start = time;
+    b->latency_sum = 0.0;
+
+    return 1;
+}
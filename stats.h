@@ -0,0 +1,49 @@
+#ifndef STATS_H
+#define STATS_H
+
+/**
+ * Média e variância de uma amostra, acumuladas uma observação por vez
+ * (algoritmo de Welford), sem guardar as observações
+ *
+ * @n: número de observações
+ * @mean: média até agora
+ * @m2: soma dos quadrados dos desvios em relação à média
+ */
+struct summary {
+    long n;
+    double mean;
+    double m2;
+};
+
+/**
+ * Médias por lote das entregas de uma simulação em regime permanente: as
+ * primeiras @warmup entregas são descartadas e as seguintes são agrupadas em
+ * lotes de @size, cada lote uma observação de vazão e de atraso médio
+ *
+ * @seen: entregas até agora, contando o aquecimento
+ * @count: entregas no lote atual
+ * @start: instante em que o lote atual começou
+ * @latency_sum: soma dos atrasos do lote atual
+ * @goodput, @latency: médias dos lotes já fechados
+ */
+struct batch_means {
+    long size;
+    long warmup;
+    long seen;
+    long count;
+    double start;
+    double latency_sum;
+    struct summary goodput;
+    struct summary latency;
+};
+
+void summary_init(struct summary *s);
+void summary_add(struct summary *s, double x);
+double summary_variance(const struct summary *s);
+double summary_ci95(const struct summary *s);
+double student_t95(long df);
+
+void batch_init(struct batch_means *b, long size, long warmup);
+int batch_add(struct batch_means *b, double time, double latency);
+
+#endif
@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "emulator.h"
+#include "replication.h"
+
+/***********************************************/
+/*            PARAMETER SWEEP ENGINE           */
+/***********************************************/
+
+#define SWEEP_MAX_AXES      16
+#define SWEEP_LINE_MAX      1024
+
+static const struct protocol *protocols[] = {
+    &go_back_n_protocol,
+    &alternating_bit_protocol,
+    &selective_repeat_protocol,
+};
+
+#define NPROTOCOLS  (int)(sizeof(protocols) / sizeof(protocols[0]))
+
+/**
+ * Um parâmetro da grade e os valores que ele assume (um só, se for fixo)
+ */
+struct axis {
+    char *key;
+    int nvalues;
+    char **values;
+};
+
+/**
+ * Grade de parâmetros: o produto cartesiano dos eixos, na ordem do arquivo
+ * (o último varia mais rápido), com @replications execuções por ponto
+ */
+struct grid {
+    struct axis axes[SWEEP_MAX_AXES];
+    int naxes;
+    int replications;
+    long npoints;
+};
+
+/**
+ * A grade e o vetor de resultados, indexado pela execução
+ * (ponto * replications + replicação)
+ */
+struct sweep {
+    const struct grid *grid;
+    struct run_result *results;
+};
+
+static const struct protocol *find_protocol(const char *name) {
+    for (int i = 0; i < NPROTOCOLS; i++) {
+        if (strcmp(protocols[i]->name, name) == 0) {
+            return protocols[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void axis_add(struct axis *axis, const char *value) {
+    axis->values = realloc(axis->values, (axis->nvalues + 1) * sizeof(char *));
+    axis->values[axis->nvalues++] = strdup(value);
+}
+
+/**
+ * Adiciona um valor ao eixo; "início:fim:passo" adiciona a sequência toda
+ */
+static int axis_add_range(struct axis *axis, char *value) {
+    double start, stop, step;
+    char buf[64];
+
+    if (strchr(value, ':') == NULL) {
+        axis_add(axis, value);
+        return 1;
+    }
+
+    if (sscanf(value, "%lf:%lf:%lf", &start, &stop, &step) != 3 || step <= 0) {
+        return 0;
+    }
+
+    for (long i = 0; start + i * step <= stop + step * 1e-9; i++) {
+        snprintf(buf, sizeof(buf), "%g", start + i * step);
+        axis_add(axis, buf);
+    }
+
+    return 1;
+}
+
+/**
+ * Confere se todos os valores do eixo são aceitos
+ */
+static int axis_check(const struct axis *axis) {
+    struct sim_config scratch;
+
+    for (int i = 0; i < axis->nvalues; i++) {
+        if (strcmp(axis->key, "protocol") == 0) {
+            if (find_protocol(axis->values[i]) == NULL) {
+                printf("unknown protocol %s\n", axis->values[i]);
+                return 0;
+            }
+
+            continue;
+        }
+
+        config_defaults(&scratch);
+
+        if (!config_set(&scratch, axis->key, axis->values[i])) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Lê a grade: uma linha 'nome = valor, valor, ...' por parâmetro, com os
+ * nomes das opções dos simuladores, mais 'protocol' e 'replications'.
+ * Retorna 0 em caso de erro.
+ */
+static int grid_load(struct grid *grid, const char *path) {
+    char line[SWEEP_LINE_MAX];
+    FILE *file = fopen(path, "r");
+    int lineno = 0, has_protocol = 0, has_messages = 0, has_lambda = 0;
+
+    memset(grid, 0, sizeof(*grid));
+    grid->replications = 1;
+
+    if (file == NULL) {
+        printf("unable to open grid file %s\n", path);
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char *key, *value;
+        struct axis *axis;
+
+        lineno++;
+
+        if (!config_split_line(line, &key, &value)) {
+            continue;
+        }
+
+        if (value == NULL) {
+            printf("%s:%d: expected 'name = values'\n", path, lineno);
+            goto error;
+        }
+
+        if (strcmp(key, "replications") == 0) {
+            if ((grid->replications = atoi(value)) < 1) {
+                printf("%s:%d: invalid number of replications\n", path, lineno);
+                goto error;
+            }
+
+            continue;
+        }
+
+        if (strcmp(key, "output") == 0 || strcmp(key, "bintrace") == 0 || strcmp(key, "summary") == 0
+            || strcmp(key, "config") == 0 || strcmp(key, "help") == 0
+            || strcmp(key, "threads") == 0) {
+            printf("%s:%d: %s can not be used in a sweep\n", path, lineno, key);
+            goto error;
+        }
+
+        if (grid->naxes == SWEEP_MAX_AXES) {
+            printf("%s:%d: too many parameters\n", path, lineno);
+            goto error;
+        }
+
+        axis = &grid->axes[grid->naxes++];
+        axis->key = strdup(key);
+
+        for (char *v = strtok(value, ","); v != NULL; v = strtok(NULL, ",")) {
+            if (!axis_add_range(axis, config_trim(v))) {
+                printf("%s:%d: invalid range %s\n", path, lineno, v);
+                goto error;
+            }
+        }
+
+        if (axis->nvalues == 0 || !axis_check(axis)) {
+            printf("%s:%d: invalid values for %s\n", path, lineno, key);
+            goto error;
+        }
+
+        has_protocol |= strcmp(key, "protocol") == 0;
+        has_messages |= strcmp(key, "messages") == 0;
+        has_lambda |= strcmp(key, "lambda") == 0;
+    }
+
+    fclose(file);
+
+    if (!has_protocol || !has_messages || !has_lambda) {
+        printf("%s: the grid needs protocol, messages and lambda\n", path);
+        return 0;
+    }
+
+    grid->npoints = 1;
+
+    for (int i = 0; i < grid->naxes; i++) {
+        grid->npoints *= grid->axes[i].nvalues;
+    }
+
+    return 1;
+
+    error:
+        fclose(file);
+        return 0;
+}
+
+/**
+ * Índice do valor do eixo @a no ponto @point
+ */
+static int grid_value(const struct grid *grid, long point, int a) {
+    for (int i = grid->naxes - 1; i > a; i--) {
+        point /= grid->axes[i].nvalues;
+    }
+
+    return point % grid->axes[a].nvalues;
+}
+
+static void run_one(void *arg, long run, FILE *log) {
+    const struct sweep *sweep = arg;
+    const struct grid *grid = sweep->grid;
+    const struct protocol *protocol = NULL;
+    long point = run / grid->replications;
+    struct sim_config config;
+
+    config_defaults(&config);
+    config.given = CONFIG_PROMPTED;
+
+    for (int a = 0; a < grid->naxes; a++) {
+        const char *value = grid->axes[a].values[grid_value(grid, point, a)];
+
+        if (strcmp(grid->axes[a].key, "protocol") == 0) {
+            protocol = find_protocol(value);
+        } else {
+            config_set(&config, grid->axes[a].key, value);
+        }
+    }
+
+    config.seed = replication_seed(config.seed, run % grid->replications);
+    run_simulation(&config, protocol, log, &sweep->results[run]);
+}
+
+/**
+ * Escreve a tabela de resultados em CSV, uma linha por execução, na ordem
+ * dos pontos (a mesma para qualquer número de threads)
+ */
+static void write_results(FILE *out, const struct grid *grid, const struct run_result *results) {
+    for (int a = 0; a < grid->naxes; a++) {
+        fprintf(out, "%s,", grid->axes[a].key);
+    }
+
+    fprintf(out, "replication,seed,time,generated,accepted,delivered,tolayer3,lost,corrupted,"
+        "retransmissions,goodput,latency,latency_p50,latency_p99,latency_p999,stopped\n");
+
+    for (long run = 0; run < grid->npoints * grid->replications; run++) {
+        const struct run_result *r = &results[run];
+        long point = run / grid->replications;
+
+        for (int a = 0; a < grid->naxes; a++) {
+            fprintf(out, "%s,", grid->axes[a].values[grid_value(grid, point, a)]);
+        }
+
+        fprintf(out, "%ld,%u,%f,%lld,%lld,%lld,%lld,%lld,%lld,%lld,%f,%f,%f,%f,%f,%d\n", run % grid->replications,
+            r->seed, r->time, r->nsim, r->naccepted, r->ntolayer5, r->ntolayer3, r->nlost, r->ncorrupt,
+            r->nretransmit, run_goodput(r), r->latency, r->latency_p50, r->latency_p99, r->latency_p999,
+            r->stopped);
+    }
+}
+
+static void usage(const char *prog) {
+    printf("usage: %s [-j threads] [-o results.csv] grid file\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    struct grid grid;
+    struct sweep sweep;
+    struct timespec start, end;
+    FILE *out = stdout;
+    int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int started, opt;
+
+    while ((opt = getopt(argc, argv, "j:o:")) != -1) {
+        switch (opt) {
+        case 'j':
+            nthreads = atoi(optarg);
+            break;
+        case 'o':
+            if ((out = fopen(optarg, "w")) == NULL) {
+                printf("unable to open output file %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (optind != argc - 1 || nthreads < 1) {
+        usage(argv[0]);
+    }
+
+    if (!grid_load(&grid, argv[optind])) {
+        return 1;
+    }
+
+    sweep.grid = &grid;
+    sweep.results = calloc(grid.npoints * grid.replications, sizeof(struct run_result));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    started = run_pool(grid.npoints * grid.replications, nthreads, run_one, &sweep);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    if (started == 0) {
+        printf("unable to run the sweep\n");
+        free(sweep.results);
+        return 1;
+    }
+
+    write_results(out, &grid, sweep.results);
+
+    fprintf(stderr, "%ld points x %d replications on %d threads in %.2f s\n",
+        grid.npoints, grid.replications, started,
+        (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+
+    if (out != stdout) {
+        fclose(out);
+    }
+
+    free(sweep.results);
+
+    return 0;
+}
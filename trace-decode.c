@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bintrace.h"
+
+/***********************************************/
+/*          BINARY TRACE DECODER               */
+/***********************************************/
+
+#define DECODE_BLOCK_RECORDS    BINTRACE_RING_RECORDS
+
+/**
+ * Filtros da linha de comando (-1 / valores negativos quando não usados)
+ */
+struct filter {
+    int entity;
+    int has_seqnum;
+    long long seqnum;
+    double from;
+    double until;
+};
+
+static const char *entity_name(int entity) {
+    return entity == 0 ? "A" : "B";
+}
+
+/**
+ * Um registro passa se for da entidade pedida, dentro da janela de tempo e,
+ * com -s, se for de um pacote com esse seqnum ou acknum
+ */
+static int matches(const struct filter *f, const struct bintrace_record *r) {
+    if (f->entity >= 0 && r->entity != f->entity) {
+        return 0;
+    }
+
+    if (f->from >= 0 && r->time < f->from) {
+        return 0;
+    }
+
+    if (f->until >= 0 && r->time > f->until) {
+        return 0;
+    }
+
+    if (f->has_seqnum) {
+        if (r->type != BT_FROM_LAYER3 && r->type != BT_TOLAYER3) {
+            return 0;
+        }
+
+        if (r->seqnum != f->seqnum && r->acknum != f->seqnum) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Imprime o registro com as linhas que o emulador escreve no trace em texto
+ * (nível 2, TRACE_EVENTS): a linha EVENT de cada evento e as de pacote
+ * perdido ou corrompido. Os outros registros não têm linha nesse trace.
+ */
+static void print_record(const struct bintrace_record *r) {
+    switch (r->type) {
+    case BT_TIMER_INTERRUPT:
+        printf("\nEVENT time: %f,  type: %d, timerinterrupt   entity: %d\n", r->time, r->type, r->entity);
+        break;
+    case BT_FROM_LAYER5:
+        printf("\nEVENT time: %f,  type: %d, fromlayer5  entity: %d\n", r->time, r->type, r->entity);
+        break;
+    case BT_FROM_LAYER3:
+        printf("\nEVENT time: %f,  type: %d, fromlayer3  entity: %d\n", r->time, r->type, r->entity);
+        break;
+    case BT_TOLAYER3:
+        if (r->flags & BT_LOST) {
+            printf("          TOLAYER3: packet being lost\n");
+        } else if (r->flags & BT_CORRUPT) {
+            printf("          TOLAYER3: packet being corrupted\n");
+        }
+        break;
+    case BT_TOLAYER5:
+    case BT_START_TIMER:
+    case BT_STOP_TIMER:
+        break;
+    default:
+        printf("          UNKNOWN RECORD: type %d at %f\n", r->type, r->time);
+        break;
+    }
+}
+
+/**
+ * Imprime o registro com tudo o que ele guarda (-x): seqnum e acknum dos
+ * pacotes, a entidade e o instante de chegada ou de expiração, e também as
+ * entregas e os timers
+ */
+static void print_record_extended(const struct bintrace_record *r) {
+    switch (r->type) {
+    case BT_FROM_LAYER3:
+        printf("\nEVENT time: %f,  type: %d, fromlayer3  entity: %d, seq: %lld, ack: %lld\n",
+            r->time, r->type, r->entity, (long long)r->seqnum, (long long)r->acknum);
+        break;
+    case BT_TOLAYER3:
+        printf("          TOLAYER3: %s sends seq: %lld, ack %lld at %f", entity_name(r->entity),
+            (long long)r->seqnum, (long long)r->acknum, r->time);
+
+        if (r->flags & BT_LOST) {
+            printf("\n          TOLAYER3: packet being lost\n");
+            break;
+        }
+
+        printf(", arrives at %f\n", r->aux);
+
+        if (r->flags & BT_CORRUPT) {
+            printf("          TOLAYER3: packet being corrupted\n");
+        }
+        break;
+    case BT_TOLAYER5:
+        printf("          TOLAYER5: data received by %s at %f\n", entity_name(r->entity), r->time);
+        break;
+    case BT_START_TIMER:
+        printf("          START TIMER: %s starting timer at %f, expires at %f\n", entity_name(r->entity), r->time, r->aux);
+        break;
+    case BT_STOP_TIMER:
+        printf("          STOP TIMER: %s stopping timer at %f\n", entity_name(r->entity), r->time);
+        break;
+    default:
+        print_record(r);
+        break;
+    }
+}
+
+static void usage(const char *prog) {
+    printf("usage: %s [-x] [-e A|B] [-s seqnum] [-f from time] [-u until time] trace file\n", prog);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    struct filter f = { -1, 0, 0, -1, -1 };
+    struct bintrace_header header;
+    struct bintrace_record *block;
+    size_t n, i;
+    FILE *file;
+    int extended = 0, opt;
+
+    while ((opt = getopt(argc, argv, "xe:s:f:u:")) != -1) {
+        switch (opt) {
+        case 'x':
+            extended = 1;
+            break;
+        case 'e':
+            if (strcmp(optarg, "A") == 0 || strcmp(optarg, "0") == 0) {
+                f.entity = 0;
+            } else if (strcmp(optarg, "B") == 0 || strcmp(optarg, "1") == 0) {
+                f.entity = 1;
+            } else {
+                usage(argv[0]);
+            }
+            break;
+        case 's':
+            f.has_seqnum = 1;
+            f.seqnum = atoll(optarg);
+            break;
+        case 'f':
+            f.from = atof(optarg);
+            break;
+        case 'u':
+            f.until = atof(optarg);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+
+    if (optind != argc - 1) {
+        usage(argv[0]);
+    }
+
+    file = fopen(argv[optind], "rb");
+
+    if (file == NULL) {
+        printf("unable to open trace file %s\n", argv[optind]);
+        return 1;
+    }
+
+    if (fread(&header, sizeof(header), 1, file) != 1
+        || memcmp(header.magic, BINTRACE_MAGIC, sizeof(header.magic)) != 0) {
+        printf("%s is not a binary trace file\n", argv[optind]);
+        return 1;
+    }
+
+    if (header.version != BINTRACE_VERSION || header.record_size != sizeof(struct bintrace_record)) {
+        printf("%s: unsupported trace version %d (record size %d)\n", argv[optind], header.version, header.record_size);
+        return 1;
+    }
+
+    block = malloc(DECODE_BLOCK_RECORDS * sizeof(struct bintrace_record));
+
+    while ((n = fread(block, sizeof(struct bintrace_record), DECODE_BLOCK_RECORDS, file)) > 0) {
+        for (i = 0; i < n; i++) {
+            if (!matches(&f, &block[i])) {
+                continue;
+            }
+
+            if (extended) {
+                print_record_extended(&block[i]);
+            } else {
+                print_record(&block[i]);
+            }
+        }
+    }
+
+    free(block);
+    fclose(file);
+
+    return 0;
+}
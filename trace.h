@@ -0,0 +1,40 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+
+#include "simulation.h"
+
+/**
+ * Níveis de trace
+ *
+ * TRACE_PROTOCOL: decisões dos protocolos, perdas e corrupções do meio
+ * (os avisos de uso errado dos timers são impressos em qualquer nível)
+ * TRACE_EVENTS: cada evento simulado e o conteúdo do buffer do remetente
+ * TRACE_DEBUG: detalhes internos do emulador (timers, inserções, pacotes)
+ */
+#define TRACE_PROTOCOL     1
+#define TRACE_EVENTS       2
+#define TRACE_DEBUG        3
+
+/**
+ * Maior nível compilado. Com TRACE_MAX_LEVEL=0 (make ... TRACE_MAX_LEVEL=0)
+ * as condições abaixo são constantes falsas e todo o trace some do binário.
+ */
+#ifndef TRACE_MAX_LEVEL
+#define TRACE_MAX_LEVEL    TRACE_DEBUG
+#endif
+
+/**
+ * Testa o nível de trace pedido para a simulação e escreve no seu log
+ */
+#define TRACE_ON(sim, level)    ((level) <= TRACE_MAX_LEVEL && (sim)->trace >= (level))
+
+#define TRACE_LOG(sim, level, ...) \
+    do { \
+        if (TRACE_ON(sim, level)) { \
+            fprintf((sim)->log, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#endif